@@ -0,0 +1,68 @@
+#ifndef TRIETREE_DICTIONARY_H
+#define TRIETREE_DICTIONARY_H
+
+#include "TRIETree.h"
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Służy do wczytania słownika do drzewa TRIE
+ *
+ * @param tree - drzewo do którego wstawiamy klucze
+ * @param path - ścieżka pliku: migawka zapisana metodą TRIETree::save albo plik tekstowy, w którym każdy wiersz
+ * to "klucz\twartość" lub sam klucz (wtedy wartością jest numer wiersza, licząc od 1)
+ * @return - ilość kluczy dodanych do drzewa, -1 jeśli pliku nie udało się wczytać
+ *
+ * jeśli plik zaczyna się nagłówkiem migawki wczytujemy go metodą TRIETree::load
+ * w przeciwnym wypadku mapujemy plik do pamięci (mmap) i wstawiamy kolejne wiersze bez kopiowania całego pliku,
+ *  pomijając wiersze z wartością 0 (0 oznacza brak klucza)
+ * ilość dodanych kluczy to przyrost rozmiaru drzewa, więc powtórzone klucze liczymy raz
+ */
+inline long loadDictionary(TRIETree &tree, const string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    size_t length = info.st_size;
+    if (length == 0) {
+        ::close(fd);
+        return 0;
+    }
+    void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return -1;
+    ::madvise(mapped, length, MADV_SEQUENTIAL);
+    const char *data = (const char *) mapped;
+
+    long lineNumber = 0;
+    if (length >= sizeof(SNAPSHOT_MAGIC) && memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0) {
+        ::munmap(mapped, length);
+        ifstream in(path, ios::binary);
+        if (!tree.load(in)) return -1;
+        return tree.size();
+    }
+
+    long before = tree.size();
+    const char *end = data + length;
+    for (const char *line = data; line < end;) {
+        const char *newline = (const char *) memchr(line, '\n', end - line);
+        if (newline == nullptr) newline = end;
+        const char *last = newline;
+        if (last > line && last[-1] == '\r') last--;
+        const char *tab = (const char *) memchr(line, '\t', last - line);
+        lineNumber++;
+        if (last > line) {
+            int value = tab == nullptr ? (int) lineNumber : (int) strtol(string(tab + 1, last).c_str(), nullptr, 10);
+            if (value != 0) tree.insert(string(line, tab == nullptr ? last : tab), value);
+        }
+        line = newline + 1;
+    }
+    ::munmap(mapped, length);
+    return tree.size() - before;
+}
+
+#endif //TRIETREE_DICTIONARY_H
@@ -0,0 +1,5311 @@
+#ifndef TRIETREE_TRIETREE_H
+#define TRIETREE_TRIETREE_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <array>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vector"
+
+using namespace std;
+
+/**
+ * Sposób rozstrzygania konfliktów w metodzie merge, gdy klucz występuje w obu drzewach
+ *
+ * KEEP_OURS - zostawiamy wartość z drzewa do którego scalamy
+ * KEEP_THEIRS - przyjmujemy wartość z drzewa scalanego
+ * SUM_VALUES - sumujemy obie wartości
+ */
+enum ConflictPolicy {
+    KEEP_OURS,
+    KEEP_THEIRS,
+    SUM_VALUES
+};
+
+/**
+ * Nagłówek i znacznik końca binarnej migawki drzewa zapisywanej metodą TRIETree::save
+ */
+const char SNAPSHOT_MAGIC[8] = {'T', 'R', 'I', 'E', 'S', 'N', 'P', '1'};
+const uint32_t SNAPSHOT_END = 0xFFFFFFFF;
+
+/**
+ * Sposób obsługi bajtów które nie rozpoczynają żadnego klucza w metodzie tokenize
+ *
+ * SKIP_UNMATCHED - pomijamy je
+ * EMIT_BYTES - każdy taki bajt zgłaszamy jako osobny token o wartości 0
+ * EMIT_RUNS - ciąg kolejnych takich bajtów zgłaszamy jako jeden token o wartości 0
+ */
+enum UnmatchedPolicy {
+    SKIP_UNMATCHED,
+    EMIT_BYTES,
+    EMIT_RUNS
+};
+
+/**
+ * Sposób sprowadzania kluczy do postaci kanonicznej, w której są przechowywane i wyszukiwane
+ *
+ * FOLD_NONE - klucze są porównywane bajt po bajcie
+ * FOLD_ASCII - wielkie litery A-Z są utożsamiane z małymi, pozostałe bajty bez zmian
+ * FOLD_UTF8 - klucze są traktowane jako UTF-8 i poddawane prostemu składaniu wielkości liter (simple case folding)
+ */
+enum FoldPolicy {
+    FOLD_NONE,
+    FOLD_ASCII,
+    FOLD_UTF8
+};
+
+/**
+ * Służy do złożenia wielkości litery znaku Unicode (simple case folding)
+ *
+ * @param c - kod znaku
+ * @return - kod znaku po złożeniu
+ *
+ * tablica obejmuje alfabet łaciński (ASCII, Latin-1, Latin Extended-A i Latin Extended Additional), grecki,
+ * cyrylicę, ormiański, znaki pełnej szerokości oraz symbole Kelvina, Angstrema i Ohma;
+ * znaki spoza tablicy pozostają bez zmian
+ */
+inline uint32_t foldCodePoint(uint32_t c) {
+    if (c < 0x80) return c >= 'A' && c <= 'Z' ? c + 0x20 : c;
+    if (c == 0xB5) return 0x3BC;
+    if (c >= 0xC0 && c <= 0xDE && c != 0xD7) return c + 0x20;
+    if (c >= 0x100 && c <= 0x17F) {
+        if (c == 0x130 || c == 0x131 || c == 0x138 || c == 0x149) return c;
+        if (c == 0x178) return 0xFF;
+        if (c == 0x17F) return 's';
+        if ((c >= 0x139 && c <= 0x148) || c >= 0x179) return c & 1 ? c + 1 : c;
+        return c & 1 ? c : c + 1;
+    }
+    if (c == 0x386) return 0x3AC;
+    if (c >= 0x388 && c <= 0x38A) return c + 0x25;
+    if (c == 0x38C) return 0x3CC;
+    if (c == 0x38E || c == 0x38F) return c + 0x3F;
+    if (c >= 0x391 && c <= 0x3AB && c != 0x3A2) return c + 0x20;
+    if (c == 0x3C2) return 0x3C3;
+    if (c >= 0x400 && c <= 0x40F) return c + 0x50;
+    if (c >= 0x410 && c <= 0x42F) return c + 0x20;
+    if ((c >= 0x460 && c <= 0x481) || (c >= 0x48A && c <= 0x4BF) || (c >= 0x4D0 && c <= 0x52F)) return c & 1 ? c : c + 1;
+    if (c == 0x4C0) return 0x4CF;
+    if (c >= 0x4C1 && c <= 0x4CE) return c & 1 ? c + 1 : c;
+    if (c >= 0x531 && c <= 0x556) return c + 0x30;
+    if (c == 0x1E9E) return 0xDF;
+    if ((c >= 0x1E00 && c <= 0x1E95) || (c >= 0x1EA0 && c <= 0x1EFF)) return c & 1 ? c : c + 1;
+    if (c == 0x2126) return 0x3C9;
+    if (c == 0x212A) return 'k';
+    if (c == 0x212B) return 0xE5;
+    if (c >= 0xFF21 && c <= 0xFF3A) return c + 0x20;
+    return c;
+}
+
+/**
+ * Służy do odczytania jednego znaku tekstu i zapisania jego postaci kanonicznej
+ *
+ * @param text - tekst
+ * @param position - pozycja znaku, po wywołaniu pozycja następnego znaku
+ * @param policy - sposób składania, FOLD_ASCII lub FOLD_UTF8
+ * @param folded - bufor na postać kanoniczną znaku, co najmniej 4 bajty
+ * @return - ilość bajtów zapisanych do bufora
+ *
+ * bajty ASCII składamy od razu
+ * w trybie FOLD_UTF8 dekodujemy znak, a niepoprawne sekwencje UTF-8 przepisujemy bajt po bajcie bez zmian
+ * jeśli złożony znak jest taki sam jak odczytany przepisujemy oryginalne bajty, w przeciwnym wypadku kodujemy go w UTF-8
+ */
+inline int foldCharacter(const string &text, size_t &position, FoldPolicy policy, char folded[4]) {
+    unsigned char lead = text[position];
+    int length = lead < 0x80 || policy != FOLD_UTF8 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC2 ? 2 : 0;
+    if (length == 1) {
+        position++;
+        folded[0] = (char) (lead >= 'A' && lead <= 'Z' ? lead + 0x20 : lead);
+        return 1;
+    }
+    uint32_t c = length == 4 ? lead & 0x07 : length == 3 ? lead & 0x0F : lead & 0x1F;
+    bool valid = length != 0 && lead <= 0xF4 && position + length <= text.size();
+    for (int i = 1; valid && i < length; i++) {
+        unsigned char next = text[position + i];
+        valid = (next & 0xC0) == 0x80;
+        c = (c << 6) | (next & 0x3F);
+    }
+    if (valid) valid = length == 2 || (length == 3 && c >= 0x800) || (length == 4 && c >= 0x10000 && c <= 0x10FFFF);
+    if (!valid) {
+        folded[0] = text[position++];
+        return 1;
+    }
+    uint32_t f = foldCodePoint(c);
+    if (f == c) {
+        text.copy(folded, length, position);
+        position += length;
+        return length;
+    }
+    position += length;
+    if (f < 0x80) {
+        folded[0] = (char) f;
+        return 1;
+    }
+    if (f < 0x800) {
+        folded[0] = (char) (0xC0 | (f >> 6));
+        folded[1] = (char) (0x80 | (f & 0x3F));
+        return 2;
+    }
+    folded[0] = (char) (0xE0 | (f >> 12));
+    folded[1] = (char) (0x80 | ((f >> 6) & 0x3F));
+    folded[2] = (char) (0x80 | (f & 0x3F));
+    return 3;
+}
+
+/**
+ * Zmiana ilości słów i sumy wartości w poddrzewie, przekazywana w górę ścieżki przez operacje modyfikujące drzewo
+ */
+struct Aggregate {
+    int count = 0;
+    long long sum = 0;
+};
+
+/**
+ * Sposób przydziału pamięci dla węzłów Node
+ *
+ * ALLOCATE_HEAP - każdy węzeł osobno ze sterty, z wyrównaniem do linii pamięci podręcznej
+ * ALLOCATE_HUGE_PAGES - węzły są układane kolejno w obszarach 2 MB oznaczonych dla jądra jako kandydaci
+ *  na duże strony (transparent huge pages), więc ścieżka wyszukiwania dotyka mniej wpisów TLB
+ */
+enum NodeAllocation {
+    ALLOCATE_HEAP,
+    ALLOCATE_HUGE_PAGES
+};
+
+/**
+ * Przydział pamięci dla węzłów Node, wspólny dla całego procesu
+ *
+ * W trybie ALLOCATE_HUGE_PAGES pojedyncze węzły są wycinane kolejno z obszarów 2 MB wyrównanych do granicy 2 MB
+ * (mmap z madvise(MADV_HUGEPAGE)), a zwolnione węzły trafiają na listę wolnych i są używane ponownie. Tablice węzłów
+ * tworzone przez TRIETree::compact dostają własny obszar o rozmiarze zaokrąglonym do 2 MB. Jeśli jądro nie obsługuje
+ * dużych stron obszary działają jak zwykła pamięć, a jeśli mmap się nie powiedzie węzeł jest przydzielany ze sterty.
+ * Tryb można zmienić w dowolnej chwili - o sposobie zwolnienia węzła decyduje adres, a nie aktualny tryb.
+ */
+class NodeArena {
+public:
+    static const size_t HUGE_PAGE = 2 << 20;
+    static const size_t CACHE_LINE = 64;
+
+    static NodeArena &instance() {
+        static NodeArena arena;
+        return arena;
+    }
+
+    void setPolicy(NodeAllocation policy) {
+        this->policy = policy;
+    }
+
+    NodeAllocation getPolicy() const {
+        return policy;
+    }
+
+    /**
+     * Służy do zwrócenia ilości bajtów zmapowanych na obszary węzłów
+     */
+    size_t mappedBytes() {
+        lock_guard<mutex> guard(lock);
+        return mapped;
+    }
+
+    void *allocate(size_t size) {
+        if (policy == ALLOCATE_HUGE_PAGES) {
+            lock_guard<mutex> guard(lock);
+            if (!freeList.empty()) {
+                void *p = freeList.back();
+                freeList.pop_back();
+                return p;
+            }
+            if (remaining < size) {
+                char *chunk = (char *) map(HUGE_PAGE);
+                if (chunk != nullptr) {
+                    mapped += HUGE_PAGE;
+                    chunks.insert((uintptr_t) chunk);
+                    current = chunk;
+                    remaining = HUGE_PAGE;
+                }
+            }
+            if (remaining >= size) {
+                void *p = current;
+                current += size;
+                remaining -= size;
+                return p;
+            }
+        }
+        return allocateAligned(size);
+    }
+
+    void deallocate(void *p) {
+        if (p == nullptr) return;
+        if (used) {
+            lock_guard<mutex> guard(lock);
+            if (chunks.count((uintptr_t) p & ~(uintptr_t) (HUGE_PAGE - 1))) {
+                freeList.push_back(p);
+                return;
+            }
+        }
+        free(p);
+    }
+
+    void *allocateArray(size_t size) {
+        if (policy == ALLOCATE_HUGE_PAGES) {
+            size_t length = (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+            void *p = map(length);
+            if (p != nullptr) {
+                lock_guard<mutex> guard(lock);
+                mapped += length;
+                regions[(uintptr_t) p] = length;
+                return p;
+            }
+        }
+        return allocateAligned(size);
+    }
+
+    void deallocateArray(void *p) {
+        if (p == nullptr) return;
+        if (used) {
+            lock_guard<mutex> guard(lock);
+            auto region = regions.find((uintptr_t) p);
+            if (region != regions.end()) {
+                ::munmap(p, region->second);
+                mapped -= region->second;
+                regions.erase(region);
+                return;
+            }
+        }
+        free(p);
+    }
+
+private:
+    atomic<NodeAllocation> policy{ALLOCATE_HEAP};
+    atomic<bool> used{false};
+    mutex lock;
+    char *current = nullptr;
+    size_t remaining = 0;
+    size_t mapped = 0;
+    vector<void *> freeList;
+    unordered_set<uintptr_t> chunks;
+    unordered_map<uintptr_t, size_t> regions;
+
+    static void *allocateAligned(size_t size) {
+        void *p;
+        if (posix_memalign(&p, CACHE_LINE, size) != 0) throw bad_alloc();
+        return p;
+    }
+
+    /**
+     * Służy do zmapowania obszaru wyrównanego do granicy 2 MB
+     *
+     * @param length - wielokrotność 2 MB
+     * @return - początek obszaru lub null
+     *
+     * mapujemy obszar większy o 2 MB i odcinamy nadmiar przed i za wyrównanym fragmentem
+     * oznaczamy obszar jako kandydata na duże strony; jeśli madvise się nie powiedzie obszar pozostaje na zwykłych stronach
+     */
+    void *map(size_t length) {
+        void *raw = ::mmap(nullptr, length + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return nullptr;
+        uintptr_t start = (uintptr_t) raw;
+        uintptr_t aligned = (start + HUGE_PAGE - 1) & ~(uintptr_t) (HUGE_PAGE - 1);
+        if (aligned > start) ::munmap(raw, aligned - start);
+        if (start + HUGE_PAGE > aligned) ::munmap((void *) (aligned + length), start + HUGE_PAGE - aligned);
+#ifdef MADV_HUGEPAGE
+        ::madvise((void *) aligned, length, MADV_HUGEPAGE);
+#endif
+        used = true;
+        return (void *) aligned;
+    }
+};
+
+/**
+ * Węzeł drzewa TRIE; węzły są wyrównane do linii pamięci podręcznej, więc wartość, liczniki
+ * i pierwsze wskaźniki węzła leżą w jednej linii
+ */
+struct alignas(NodeArena::CACHE_LINE) Node {
+    int value = 0;
+    int count = 0;
+    long long sum = 0;
+    struct Node *next[256];
+
+    static void *operator new(size_t size) {
+        return NodeArena::instance().allocate(size);
+    }
+
+    static void operator delete(void *p) {
+        NodeArena::instance().deallocate(p);
+    }
+
+    static void *operator new[](size_t size) {
+        return NodeArena::instance().allocateArray(size);
+    }
+
+    static void operator delete[](void *p) {
+        NodeArena::instance().deallocateArray(p);
+    }
+};
+
+/**
+ * Uogólniony indeks sufiksowy kluczy drzewa TRIE, służy do wyszukiwania kluczy zawierających dany podciąg
+ *
+ * Każdy sufiks każdego klucza jest wstawiany do rzadkiego drzewa sufiksów. Węzeł pamięta klucze (oraz ile razy)
+ * których sufiksy przez niego przechodzą, więc zapytanie kosztuje O(|wzorzec| + ilość wyników).
+ * Indeks zajmuje O(długość klucza ^ 2) na klucz, dlatego jest opcjonalny.
+ */
+class SuffixIndex {
+private:
+    struct SuffixNode {
+        vector<pair<unsigned char, SuffixNode *>> next;
+        unordered_map<int, int> owners;
+    };
+
+    SuffixNode root;
+    unordered_map<string, int> ids;
+    vector<string> keys;
+    vector<int> freeIds;
+
+    /**
+     * Służy do znalezienia dziecka węzła odpowiadającego literze c
+     *
+     * @param x - węzeł
+     * @param c - litera
+     * @param create - czy utworzyć dziecko jeśli nie istnieje
+     * @return - dziecko lub null
+     */
+    static SuffixNode *child(SuffixNode *x, unsigned char c, bool create) {
+        auto edge = lower_bound(x->next.begin(), x->next.end(), make_pair(c, (SuffixNode *) nullptr));
+        if (edge != x->next.end() && edge->first == c) return edge->second;
+        if (!create) return nullptr;
+        return x->next.insert(edge, make_pair(c, new SuffixNode()))->second;
+    }
+
+    static void destroy(SuffixNode *x) {
+        for (auto &edge : x->next)
+            destroy(edge.second);
+        delete x;
+    }
+
+public:
+    SuffixIndex() = default;
+    SuffixIndex(const SuffixIndex &) = delete;
+    SuffixIndex &operator=(const SuffixIndex &) = delete;
+
+    ~SuffixIndex() {
+        clear();
+    }
+
+    /**
+     * Służy do dodania klucza do indeksu, ponowne dodanie klucza nic nie zmienia
+     *
+     * @param key - klucz
+     *
+     * przydzielamy kluczowi identyfikator
+     * dla każdego sufiksu klucza schodzimy w dół drzewa tworząc brakujące węzły
+     * i zwiększamy licznik klucza w każdym odwiedzonym węźle
+     */
+    void add(const string &key) {
+        if (ids.count(key)) return;
+        int id;
+        if (freeIds.empty()) {
+            id = keys.size();
+            keys.push_back(key);
+        } else {
+            id = freeIds.back();
+            freeIds.pop_back();
+            keys[id] = key;
+        }
+        ids[key] = id;
+        for (size_t i = 0; i < key.size(); i++) {
+            SuffixNode *x = &root;
+            for (size_t j = i; j < key.size(); j++) {
+                x = child(x, key[j], true);
+                x->owners[id]++;
+            }
+        }
+    }
+
+    /**
+     * Służy do usunięcia klucza z indeksu
+     *
+     * @param key - klucz
+     *
+     * dla każdego sufiksu klucza schodzimy w dół drzewa zmniejszając licznik klucza
+     * jeśli przez węzeł nie przechodzi już żaden sufiks, to nie przechodzi też przez jego poddrzewo,
+     *  więc odpinamy i zwalniamy całe poddrzewo
+     */
+    void remove(const string &key) {
+        auto found = ids.find(key);
+        if (found == ids.end()) return;
+        int id = found->second;
+        for (size_t i = 0; i < key.size(); i++) {
+            SuffixNode *x = &root;
+            for (size_t j = i; j < key.size(); j++) {
+                unsigned char c = key[j];
+                auto edge = lower_bound(x->next.begin(), x->next.end(), make_pair(c, (SuffixNode *) nullptr));
+                SuffixNode *y = edge->second;
+                auto owner = y->owners.find(id);
+                if (--owner->second == 0) y->owners.erase(owner);
+                if (y->owners.empty()) {
+                    x->next.erase(edge);
+                    destroy(y);
+                    break;
+                }
+                x = y;
+            }
+        }
+        ids.erase(found);
+        keys[id].clear();
+        freeIds.push_back(id);
+    }
+
+    /**
+     * Służy do znalezienia wszystkich kluczy zawierających dany podciąg
+     *
+     * @param pattern - szukany podciąg
+     * @return - klucze zawierające podciąg, w porządku leksykograficznym
+     *
+     * schodzimy w dół drzewa po literach wzorca
+     * kluczami zawierającymi wzorzec są właściciele węzła w którym się zatrzymaliśmy
+     */
+    vector<string> keysContaining(const string &pattern) const {
+        vector<string> queue;
+        if (pattern.empty()) {
+            for (auto &entry : ids) queue.push_back(entry.first);
+        } else {
+            SuffixNode *x = const_cast<SuffixNode *>(&root);
+            for (size_t d = 0; x != nullptr && d < pattern.size(); d++)
+                x = child(x, pattern[d], false);
+            if (x != nullptr)
+                for (auto &owner : x->owners) queue.push_back(keys[owner.first]);
+        }
+        sort(queue.begin(), queue.end());
+        return queue;
+    }
+
+    void clear() {
+        for (auto &edge : root.next)
+            destroy(edge.second);
+        root.next.clear();
+        ids.clear();
+        keys.clear();
+        freeIds.clear();
+    }
+};
+
+/**
+ * Filtr Blooma kluczy drzewa TRIE, służy do odrzucania zapytań o klucze których na pewno nie ma w drzewie
+ *
+ * Klucz jest reprezentowany przez hashes bitów wyznaczonych podwójnym haszowaniem. Odpowiedź "nie ma" jest zawsze pewna,
+ * odpowiedź "może być" jest błędna z prawdopodobieństwem zależnym od ilości bitów na klucz (dla 10 bitów około 1%).
+ * Z filtra nie da się usuwać kluczy, więc po usunięciach należy go przebudować.
+ */
+class LookupFilter {
+private:
+    vector<uint64_t> bits;
+    int hashes;
+    size_t capacity;
+    size_t added = 0;
+
+    /**
+     * Służy do wyznaczenia pary skrótów, z których wyliczane są pozycje bitów, ze skrótu klucza
+     */
+    static void split(uint64_t h, uint64_t &h1, uint64_t &h2) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h1 = h;
+        h2 = (h * 0x9e3779b97f4a7c15ULL) | 1;
+    }
+
+public:
+    static const uint64_t HASH_SEED = 14695981039346656037ULL;
+
+    /**
+     * Służy do dołączenia kolejnego bajtu klucza do skrótu (FNV-1a), dzięki czemu klucz można haszować
+     * bajt po bajcie, np. z kursora, bez budowania łańcucha
+     */
+    static uint64_t hashByte(uint64_t h, unsigned char c) {
+        return (h ^ c) * 1099511628211ULL;
+    }
+
+    /**
+     * @param capacity - ilość kluczy, po przekroczeniu której filtr należy przebudować
+     * @param bitsPerKey - ilość bitów na klucz
+     */
+    LookupFilter(size_t capacity, int bitsPerKey) : capacity(capacity) {
+        bits.assign(max((size_t) 1, (capacity * bitsPerKey + 63) / 64), 0);
+        hashes = max(1, (int) (bitsPerKey * 0.69 + 0.5));
+    }
+
+    /**
+     * @param hash - skrót klucza wyliczony przez hashByte
+     */
+    void add(uint64_t hash) {
+        uint64_t h1, h2;
+        split(hash, h1, h2);
+        uint64_t size = bits.size() * 64;
+        for (int i = 0; i < hashes; i++) {
+            uint64_t bit = (h1 + i * h2) % size;
+            bits[bit / 64] |= 1ULL << (bit % 64);
+        }
+        added++;
+    }
+
+    /**
+     * Służy do sprawdzenia czy klucz może znajdować się w drzewie
+     *
+     * @param hash - skrót klucza wyliczony przez hashByte
+     * @return - false jeśli klucza na pewno nie ma w drzewie
+     */
+    bool mayContain(uint64_t hash) const {
+        uint64_t h1, h2;
+        split(hash, h1, h2);
+        uint64_t size = bits.size() * 64;
+        for (int i = 0; i < hashes; i++) {
+            uint64_t bit = (h1 + i * h2) % size;
+            if (!(bits[bit / 64] & (1ULL << (bit % 64)))) return false;
+        }
+        return true;
+    }
+
+    bool full() const {
+        return added > capacity;
+    }
+};
+
+/**
+ * Statystyki filtra kluczy: ilość zapytań, ilość zapytań odrzuconych przez filtr bez przeszukiwania drzewa
+ * oraz ilość zapytań przepuszczonych przez filtr o klucze których w drzewie nie było
+ */
+struct LookupFilterStats {
+    uint64_t queries = 0;
+    uint64_t rejected = 0;
+    uint64_t falsePositives = 0;
+    double hitRate = 0;
+    double falsePositiveRate = 0;
+};
+
+/**
+ * Pula wątków z podkradaniem zadań (work stealing)
+ *
+ * Zadania są numerowane od 0 do count - 1 i rozdzielane po równo między kolejki wątków. Wątek pobiera zadania
+ * z początku własnej kolejki, a gdy ta się opróżni podkrada zadania z końca kolejek pozostałych wątków,
+ * dzięki czemu nierówne zadania (poddrzewa różnej wielkości) nie zostawiają bezczynnych rdzeni.
+ */
+class WorkStealingPool {
+private:
+    struct TaskQueue {
+        mutex lock;
+        deque<size_t> tasks;
+    };
+
+    int threads;
+
+    static bool take(TaskQueue &queue, bool front, size_t &task) {
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        if (front) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        } else {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        return true;
+    }
+
+public:
+    /**
+     * Konstruktor
+     *
+     * @param threads - ilość wątków, 0 oznacza ilość rdzeni procesora
+     */
+    explicit WorkStealingPool(int threads = 0)
+            : threads(threads > 0 ? threads : max(1, (int) thread::hardware_concurrency())) {}
+
+    /**
+     * Służy do wykonania zadań równolegle, wraca gdy wszystkie zadania się zakończą
+     *
+     * @param count - ilość zadań
+     * @param task - funkcja wywoływana z numerem zadania
+     */
+    template<typename Task>
+    void run(size_t count, Task task) {
+        int workers = (int) min((size_t) threads, max(count, (size_t) 1));
+        vector<TaskQueue> queues(workers);
+        for (size_t i = 0; i < count; i++)
+            queues[i % workers].tasks.push_back(i);
+        auto worker = [&](int self) {
+            size_t next;
+            for (;;) {
+                bool found = take(queues[self], true, next);
+                for (int k = 1; !found && k < workers; k++)
+                    found = take(queues[(self + k) % workers], false, next);
+                if (!found) return;
+                task(next);
+            }
+        };
+        vector<thread> pool;
+        for (int w = 1; w < workers; w++)
+            pool.emplace_back(worker, w);
+        worker(0);
+        for (auto &t : pool)
+            t.join();
+    }
+};
+
+class TRIETree {
+private:
+    /**
+     * Ilość górnych poziomów drzewa układanych przez compact wszerz, niższe poziomy układane są w głąb
+     */
+    static const int BFS_LEVELS = 3;
+
+    /**
+     * Ilość poziomów pod węzłem przedrostka dzielonych na osobne zadania w metodach równoległych
+     */
+    static const int PARALLEL_LEVELS = 2;
+
+    /**
+     * Poddrzewo przetwarzane jako jedno zadanie w metodach równoległych;
+     * jeśli whole = false zadanie obejmuje tylko klucz kończący się w węźle x, bez jego dzieci
+     */
+    struct Subtree {
+        Node *x;
+        string prefix;
+        bool whole;
+    };
+
+    atomic<Node *> root;
+    vector<pair<Node *, size_t>> regions;
+    unique_ptr<SuffixIndex> suffixes;
+    unique_ptr<TRIETree> reversed;
+    mutex updateLock;
+    FoldPolicy folding = FOLD_NONE;
+    unique_ptr<LookupFilter> filter;
+    int filterBitsPerKey = 10;
+    atomic<uint64_t> filterQueries{0};
+    atomic<uint64_t> filterRejected{0};
+    atomic<uint64_t> filterFalsePositives{0};
+    atomic<unsigned> epoch{0};
+    atomic<int> readers[2] = {{0}, {0}};
+
+    /**
+     * Rejestracja odczytu na czas wywołania metody, dzięki której compact nie zwolni węzłów używanych przez odczyt
+     *
+     * odczyt zwiększa licznik czytelników epoki w której się zaczął; jeśli w międzyczasie epoka się zmieniła
+     * wycofuje się i próbuje ponownie, więc każdy zarejestrowany odczyt widzi korzeń nie starszy niż poprzednia epoka
+     * rejestracje można zagnieżdżać, odczyt nigdy nie czeka na compact
+     */
+    struct ReadGuard {
+        TRIETree &tree;
+        unsigned slot;
+
+        explicit ReadGuard(TRIETree &tree) : tree(tree) {
+            for (;;) {
+                unsigned current = tree.epoch.load();
+                slot = current & 1;
+                tree.readers[slot].fetch_add(1);
+                if (tree.epoch.load() == current) break;
+                tree.readers[slot].fetch_sub(1);
+            }
+        }
+
+        ~ReadGuard() {
+            tree.readers[slot].fetch_sub(1);
+        }
+    };
+
+    /**
+     * Służy do zaczekania aż zakończą się wszystkie odczyty, które mogły widzieć korzeń sprzed podmiany
+     *
+     * przechodzimy do nowej epoki i czekamy aż licznik czytelników poprzedniej epoki spadnie do zera;
+     * odczyty zaczęte w nowej epoce widzą już nowy korzeń, więc nie trzeba na nie czekać
+     */
+    void waitForReaders() {
+        unsigned previous = epoch.fetch_add(1);
+        while (readers[previous & 1].load() != 0) this_thread::yield();
+    }
+
+    /**
+     * Służy do odbudowania indeksu sufiksowego po operacjach zmieniających całe poddrzewa
+     */
+    void rebuildSuffixIndex() {
+        if (!suffixes) return;
+        suffixes->clear();
+        for (auto &key : keys()) suffixes->add(key);
+    }
+
+    /**
+     * Służy do odbudowania drzewa odwróconych kluczy
+     */
+    void rebuildReverseIndex() {
+        if (!reversed) return;
+        reversed->deletePrefix("");
+        forEach("", [this](const string &key, int &) {
+            reversed->insert(string(key.rbegin(), key.rend()), 1);
+            return true;
+        });
+    }
+
+    void rebuildIndexes() {
+        rebuildSuffixIndex();
+        rebuildReverseIndex();
+    }
+
+    /**
+     * Służy do uaktualnienia indeksu sufiksowego i drzewa odwróconych kluczy po wstawieniu lub usunięciu klucza
+     *
+     * @param key - klucz w postaci kanonicznej
+     * @param present - czy klucz jest w drzewie po zmianie
+     */
+    void updateIndexes(const string &key, bool present) {
+        if (suffixes) {
+            if (present) suffixes->add(key);
+            else suffixes->remove(key);
+        }
+        if (reversed) {
+            string mirrored(key.rbegin(), key.rend());
+            if (present) reversed->insert(mirrored, 1);
+            else reversed->del(mirrored);
+        }
+    }
+
+    /**
+     * Kursor zwracający kolejne bajty postaci kanonicznej klucza, bez budowania nowego łańcucha
+     *
+     * position wskazuje pierwszy nieodczytany bajt oryginalnego klucza, boundary() mówi czy odczytane bajty
+     * kończą się na granicy znaku
+     */
+    struct FoldedKey {
+        const string &key;
+        FoldPolicy policy;
+        size_t position = 0;
+        char buffer[4];
+        int length = 0;
+        int index = 0;
+
+        FoldedKey(const string &key, FoldPolicy policy) : key(key), policy(policy) {}
+
+        bool next(unsigned char &c) {
+            if (index == length) {
+                if (position == key.size()) return false;
+                if (policy == FOLD_NONE) {
+                    c = key[position++];
+                    return true;
+                }
+                length = foldCharacter(key, position, policy, buffer);
+                index = 0;
+            }
+            c = buffer[index++];
+            return true;
+        }
+
+        bool boundary() const {
+            return index == length;
+        }
+    };
+
+    /**
+     * Służy do sprowadzenia klucza do postaci kanonicznej, używane przez metody modyfikujące drzewo
+     */
+    string fold(const string &key) const {
+        string canonical;
+        canonical.reserve(key.size());
+        char buffer[4];
+        for (size_t position = 0; position < key.size();)
+            canonical.append(buffer, foldCharacter(key, position, folding, buffer));
+        return canonical;
+    }
+
+    /**
+     * Służy do znalezienia węzła klucza, klucz jest składany w trakcie schodzenia w dół drzewa
+     *
+     * @param key - klucz, w dowolnej wielkości liter
+     * @param canonical - jeśli nie jest null, dopisujemy do niego postać kanoniczną przebytej ścieżki
+     * @return - węzeł klucza lub null
+     */
+    Node *find(const string &key, string *canonical = nullptr) {
+        Node *x = root;
+        FoldedKey cursor(key, folding);
+        unsigned char c;
+        while (x != nullptr && cursor.next(c)) {
+            if (canonical) canonical->push_back((char) c);
+            x = x->next[c];
+        }
+        return x;
+    }
+
+    /**
+     * Służy do wyliczenia skrótu klucza dla filtra kluczy z kolejnych bajtów jego postaci kanonicznej
+     *
+     * @param key - klucz
+     * @param policy - FOLD_NONE dla klucza już sprowadzonego do postaci kanonicznej, folding dla klucza z zapytania
+     */
+    static uint64_t filterHash(const string &key, FoldPolicy policy) {
+        FoldedKey cursor(key, policy);
+        uint64_t h = LookupFilter::HASH_SEED;
+        unsigned char c;
+        while (cursor.next(c)) h = LookupFilter::hashByte(h, c);
+        return h;
+    }
+
+    /**
+     * Służy do dodania wstawionego klucza do filtra kluczy; jeśli filtr przekroczył pojemność budujemy go od nowa, większy
+     */
+    void addToLookupFilter(const string &key) {
+        if (!filter) return;
+        filter->add(filterHash(key, FOLD_NONE));
+        if (filter->full()) rebuildLookupFilter();
+    }
+
+    /**
+     * Służy do zwolnienia pojedynczego węzła
+     *
+     * @param x - węzeł
+     *
+     * węzły należące do ciągłego obszaru utworzonego przez compact nie są zwalniane pojedynczo,
+     * cały obszar zwalniamy przy kolejnym compact
+     */
+    void freeNode(Node *x) {
+        less<Node *> before;
+        for (auto &region : regions)
+            if (!before(x, region.first) && before(x, region.first + region.second))
+                return;
+        delete x;
+    }
+
+    /**
+     * Służy do zwracania wartości powiązanej z kluczem z drzewa TRIE o korzeniu x
+     *
+     * @param x - węzeł od którego rozpoczynamy wyszukiwanie
+     * @param key - klucz, słowo którego szukamy
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @return - jeżeli nie znajdujemy wartości zwracamy null, jeśli znajdujemy to zwracamy powiązany z nią węzeł
+     *
+     * jeśli (węzeł nie istnieje) zwracamy null
+       jeśli (aktualnie przetwarzana litera = długość słowa) zwracamy znaleziony węzeł
+       deklaracja kolejnej litery w słowie i przypisanie do niej słowa którego szukamy[indeks aktualnie przetwarzanej litery w słowie]
+       przechodzimy do następnego węzła oraz sprawdzamy następną literę w danym słowie; rekurencyjnie wywołujemy metodę get z nastepującymi argumentami(następny węzeł odpowiadający konkretnej literze)
+       klucz, indeks aktualnie przetwarzanej litery w kluczu +1)
+     *
+     */
+    Node *get(Node *x, string key, size_t d) {
+        if (x == nullptr) return nullptr;
+        if (d == key.length()) return x;
+        unsigned char c = key[d];
+        return get(x->next[c], key, d + 1);
+    }
+
+
+    /**
+     * Służy do wstawiania słowa do drzewa TRIE
+     *
+     * @param x - węzeł od którego rozpoczynamy wstawianie
+     * @param key - klucz, słowo które wstawiamy
+     * @param value - wartość odpowiadająca danemu słowu
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @return - zwraca przetworzony węzeł
+     *
+     * @param delta - zmiana ilości słów i sumy wartości spowodowana wstawieniem
+     *
+     * jeśli węzeł x nie istnieje
+     *  tworzymy go
+       jeśli aktualnie przetwarzana pozycja w słowie jest równa jego ostatniemu znakowi
+        wyliczamy zmianę ilości słów i sumy wartości względem poprzedniej wartości
+        do węzła końcowego przypisujemy wartość odpowiadającą wstawianemu słowu
+        usuwa klucz jeśli wartość przypisana danemu słowu jest równa 0
+        i zwracamy ten wezeł
+
+       deklaracja kolejnej litery w słowie i przypisanie do niej słowa które wstawiamy[indeks aktualnie przetwarzanej litery w słowie]
+       ustawienie następnego poziomu węzła[na kolejną literę w słowie] - rekurencyjnie wywołanie tej samej metody aby w następnym poziomie wstawić daną literę
+       (węzeł[następny poziom],słowo którego szukamy,wartość odpowiadająca danemu słowu, indeks aktualnie przetwarzanej litery w kluczu +1)
+       dodajemy zmianę do licznika i sumy węzła
+       zwracamy węzeł końcowy
+     */
+    Node *insert(Node *x, string key, int value, size_t d, Aggregate &delta) {
+        if (x == nullptr) {
+            x = new Node();
+        }
+        if (d == key.size()) {
+            delta.count = (value != 0) - (x->value != 0);
+            delta.sum = (long long) value - x->value;
+        } else {
+            unsigned char c = key[d];
+            x->next[c] = insert(x->next[c], key, value, d + 1, delta);
+        }
+        if (d == key.size()) x->value = value;
+        x->count += delta.count;
+        x->sum += delta.sum;
+        return x;
+    }
+
+    /**
+     * Służy do wyszukiwania najdłuższego przedrostka danego słowa
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param query - łańcuch znaków dla którego szukamy najdłuższego przedrostka
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @param length - ilość już pasujących do słowa liter
+     * @param value - wartość klucza o długości length
+     * @return - zwraca ilość aktualnie pasujących do słowa liter
+     *
+     * jeśli (węzeł który aktualnie przetwarzamy nie istnieje) zwracamy zwraca ilość aktualnie pasujących do słowa liter
+       jeśli (w danym węźle kończy się słowo) ilość aktualnie pasujących do słowa liter = indeks aktualnie przetwarzanej litery w słowie,
+        a wartość = wartość w węźle;
+       jeśli (indeks aktualnie przetwarzanej litery w słowie jest rowny długości słowa) zwracamy długość przedrostka jako całe słowo
+       deklaracja kolejnej litery w słowie = słowo którego prefiksu szukamy [indeks aktualnie przetwarzanej litery w słowie]
+       sprawdzamy następny poziom w drzewie dla następnej litery - rekurencyjne wywołujemy te samą metodę z argumentami (węzeł[następny poziom],łańcuch znaków dla którego szukamy najdłuższego przedrostka,
+       indeks aktualnie przetwarzanej litery w słowie,ilość już pasujących do słowa liter, wartość)
+     */
+    int longestPrefixOf(Node *x, const string &query, size_t d, int length, int &value) {
+        if (x == nullptr) return length;
+        if (x->value != 0) {
+            length = (int) d;
+            value = x->value;
+        }
+        if (d == query.length()) return length;
+        unsigned char c = query[d];
+        return longestPrefixOf(x->next[c], query, d + 1, length, value);
+    }
+
+    /**
+     * Służy do zapisywania kluczy w metodach keys i keysWithPrefix
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param key - klucz którego część już dopasowaliśmy
+     * @param queue - służy do przechowywania wszystkich słów
+     *
+     * jeśli węzeł jest pusty
+     *  przerywamy pracę metody
+       jeśli w danym węźle kończy się słowo
+        dodaj słowo do wektora
+       przechodzimy przez cały alfabet w danym węźle
+        i wywołujemy rekurencyjnie metodę collect z argumentami (węzeł odpowiadający danej literze w alfabecie,klucz zwiększony o daną literę w alfabecie,
+        vector)
+        aby znaleźć pozostałe słowa
+     */
+    void collect(Node *x, string key, vector<string> &queue) {
+        if (x == nullptr) {
+            return;
+        }
+        if (x->value != 0) {
+            queue.push_back(key);
+        }
+        for (int c = 0; c < 256; c++) {
+            collect(x->next[c], key + (char) c, queue);
+        }
+    }
+
+    /**
+     * Służy do usuwania kluczy z drzewa TRIE
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param key - klucz który zostanie usunięty
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @param delta - zmiana ilości słów i sumy wartości spowodowana usunięciem
+     * @return - zwraca przetworzony węzeł
+     *
+     * jeśli (węzeł który aktualnie przetwarzamy jest pusty) zwracamy null;
+        jeśli (indeks aktualnie przetwarzanej litery w słowie jest równy długości słowa) zapamiętaj zmianę i usuń znacznik końca słowa w danym węźle poprzez przypisanie do niego wartośći 0
+        w przeciwnym wypadku
+         deklaracja kolejnej litery w słowie = słowo którego prefiksu szukamy [indeks aktualnie przetwarzanej litery w słowie]
+         rekurencyjne wywołanie metody usuwającej kolejne litery danego słowa klucza z argumentami(węzeł[następny poziom],
+         klucz, indeks aktualnie przetwarzanej litery w słowie + 1)
+        dodaj zmianę do licznika i sumy węzła
+
+        jeśli (wartość w aktualnie przetwarzanym węźle nie jest równa 0) zwracamy aktualnie przetwarzany węzeł;
+        przejdź przez cały alfabet w danym węźle
+            jeśli następny znak nie jest nullem
+                zwracamy aktualnie przetwarzany węzeł;
+        zwalniamy węzeł i zwracamy null;
+     */
+    Node *del(Node *x, string key, size_t d, Aggregate &delta) {
+        if (x == nullptr) return nullptr;
+        if (d == key.length()) {
+            delta.count = -(x->value != 0);
+            delta.sum = -(long long) x->value;
+            x->value = 0;
+        } else {
+            unsigned char c = key[d];
+            x->next[c] = del(x->next[c], key, d + 1, delta);
+        }
+        x->count += delta.count;
+        x->sum += delta.sum;
+        return prune(x);
+    }
+
+
+    /** Służy do zwracania ilości słów w poddrzewie
+     *
+     * @param x - węzeł od którego rozpoczynamy sprawdzanie
+     * @return - ilość słów w poddrzewie
+     *
+     * jeśli węzeł od którego rozpoczynamy sprawdzanie nie istnieje zwracamy 0
+        w przeciwnym wypadku zwracamy licznik słów poddrzewa, aktualizowany przez operacje modyfikujące drzewo
+     */
+    int size(Node *x) {
+        if (x == nullptr) return 0;
+        return x->count;
+    }
+
+    /**
+     * Służy do przeliczenia licznika słów i sumy wartości węzła na podstawie jego wartości i liczników dzieci
+     *
+     * @param x - węzeł, którego dzieci mają już poprawne liczniki
+     */
+    void refresh(Node *x) {
+        x->count = x->value != 0;
+        x->sum = x->value;
+        for (int c = 0; c < 256; c++)
+            if (x->next[c] != nullptr) {
+                x->count += x->next[c]->count;
+                x->sum += x->next[c]->sum;
+            }
+    }
+
+    /**
+     * Służy do zwolnienia pamięci całego poddrzewa
+     *
+     * @param x - korzeń poddrzewa
+     * @return - ilość słów które znajdowały się w poddrzewie
+     *
+     * przechodzimy poddrzewo iteracyjnie z użyciem własnego stosu, aby bardzo duże poddrzewa nie przepełniły stosu wywołań
+     * dla każdego zdjętego ze stosu węzła
+     *  jeśli kończy się w nim słowo inkrementujemy licznik
+     *  wstawiamy na stos wszystkie jego dzieci
+     *  zwalniamy węzeł
+     */
+    int destroy(Node *x) {
+        int counter = 0;
+        vector<Node *> stack;
+        if (x != nullptr) stack.push_back(x);
+        while (!stack.empty()) {
+            Node *y = stack.back();
+            stack.pop_back();
+            if (y->value != 0) counter++;
+            for (int c = 0; c < 256; c++)
+                if (y->next[c] != nullptr)
+                    stack.push_back(y->next[c]);
+            freeNode(y);
+        }
+        return counter;
+    }
+
+    /**
+     * Służy do odwiedzenia wszystkich par klucz-wartość poddrzewa w metodzie forEach
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param key - klucz którego część już dopasowaliśmy, jeden bufor rozszerzany i skracany w miejscu
+     * @param visitor - funkcja odwiedzająca
+     * @param delta - zmiana ilości słów i sumy wartości spowodowana zmianą wartości przez funkcję odwiedzającą
+     * @return - false jeśli funkcja odwiedzająca przerwała przechodzenie
+     *
+     * jeśli w węźle kończy się słowo wywołujemy funkcję odwiedzającą i zapamiętujemy zmianę wartości
+     * wywołujemy rekurencyjnie metodę dla każdego istniejącego dziecka, przerywając gdy któreś wywołanie zwróci false
+     * dodajemy zmiany do licznika i sumy węzła
+     */
+    template<typename Visitor>
+    bool forEach(Node *x, string &key, Visitor &visitor, Aggregate &delta) {
+        if (x == nullptr) return true;
+        Aggregate changes;
+        bool running = true;
+        if (x->value != 0) {
+            int old = x->value;
+            running = visitor((const string &) key, x->value);
+            changes.count = (x->value != 0) - 1;
+            changes.sum = (long long) x->value - old;
+        }
+        for (int c = 0; running && c < 256; c++) {
+            if (x->next[c] == nullptr) continue;
+            key.push_back((char) c);
+            running = forEach(x->next[c], key, visitor, changes);
+            key.pop_back();
+        }
+        if (changes.count != 0 || changes.sum != 0) {
+            x->count += changes.count;
+            x->sum += changes.sum;
+            delta.count += changes.count;
+            delta.sum += changes.sum;
+        }
+        return running;
+    }
+
+    /**
+     * Służy do podzielenia poddrzewa na zadania dla metod równoległych, w porządku leksykograficznym
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param prefix - klucz odpowiadający węzłowi x
+     * @param levels - ilość poziomów które jeszcze dzielimy
+     * @param tasks - lista zadań
+     *
+     * jeśli nie dzielimy już dalej całe poddrzewo staje się jednym zadaniem
+     * w przeciwnym wypadku klucz kończący się w węźle jest osobnym zadaniem, a dzieci dzielimy rekurencyjnie
+     */
+    void splitSubtrees(Node *x, const string &prefix, int levels, vector<Subtree> &tasks) {
+        if (x == nullptr) return;
+        if (levels == 0) {
+            tasks.push_back({x, prefix, true});
+            return;
+        }
+        if (x->value != 0) tasks.push_back({x, prefix, false});
+        for (int c = 0; c < 256; c++)
+            if (x->next[c] != nullptr)
+                splitSubtrees(x->next[c], prefix + (char) c, levels - 1, tasks);
+    }
+
+    /**
+     * Służy do wykonania funkcji odwiedzającej dla wszystkich par klucz-wartość poddrzew, równolegle dla kolejnych poddrzew
+     *
+     * @param tasks - poddrzewa wyznaczone przez splitSubtrees
+     * @param threads - ilość wątków
+     * @param visitor - wywoływana z argumentami (numer poddrzewa, klucz, wartość)
+     */
+    template<typename Visitor>
+    void parallelVisit(vector<Subtree> &tasks, int threads, Visitor visitor) {
+        WorkStealingPool(threads).run(tasks.size(), [&](size_t task) {
+            Subtree &subtree = tasks[task];
+            auto visit = [&](const string &key, int &value) {
+                visitor(task, key, value);
+                return true;
+            };
+            Aggregate unchanged;
+            if (subtree.whole) forEach(subtree.x, subtree.prefix, visit, unchanged);
+            else visit(subtree.prefix, subtree.x->value);
+        });
+    }
+
+    /**
+     * Służy do zgłaszania tokenów w metodach tokenize, zgodnie z polityką dla niedopasowanych bajtów
+     */
+    template<typename Callback>
+    struct TokenEmitter {
+        Callback &callback;
+        UnmatchedPolicy policy;
+        size_t runStart = 0;
+        size_t runLength = 0;
+
+        TokenEmitter(Callback &callback, UnmatchedPolicy policy) : callback(callback), policy(policy) {}
+
+        void match(size_t offset, size_t length, int value) {
+            finish();
+            callback(offset, length, value);
+        }
+
+        void unmatched(size_t offset) {
+            if (policy == EMIT_BYTES) callback(offset, (size_t) 1, 0);
+            if (policy != EMIT_RUNS) return;
+            if (runLength == 0) runStart = offset;
+            runLength++;
+        }
+
+        void finish() {
+            if (runLength > 0) callback(runStart, runLength, 0);
+            runLength = 0;
+        }
+    };
+
+    /**
+     * Służy do znalezienia najdłuższego klucza będącego przedrostkiem fragmentu danych
+     *
+     * @param data - dane
+     * @param length - ilość dostępnych bajtów
+     * @param last - czy za dostępnymi bajtami nie ma już dalszych danych
+     * @param matched - długość najdłuższego pasującego klucza, 0 jeśli żaden nie pasuje
+     * @param value - wartość najdłuższego pasującego klucza
+     * @return - false jeśli dane skończyły się zanim skończyła się ścieżka w drzewie i trzeba doczytać kolejne bajty
+     *
+     * schodzimy od korzenia po kolejnych bajtach zapamiętując ostatni węzeł w którym kończy się słowo
+     */
+    bool longestMatch(const char *data, size_t length, bool last, size_t &matched, int &value) {
+        matched = 0;
+        value = 0;
+        Node *x = root;
+        for (size_t d = 0; x != nullptr;) {
+            if (d > 0 && x->value != 0) {
+                matched = d;
+                value = x->value;
+            }
+            if (d == length) return last;
+            x = x->next[(unsigned char) data[d++]];
+        }
+        return true;
+    }
+
+    /**
+     * Służy do zapisania wszystkich par klucz-wartość poddrzewa w metodzie save
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param key - klucz którego część już dopasowaliśmy, bufor jest rozszerzany i skracany w miejscu
+     * @param out - strumień binarny
+     *
+     * jeśli w węźle kończy się słowo zapisujemy rekord (długość klucza, wartość, klucz)
+     * wywołujemy rekurencyjnie metodę dla każdego istniejącego dziecka
+     */
+    void save(Node *x, string &key, ostream &out) {
+        if (x == nullptr) return;
+        if (x->value != 0) {
+            uint32_t length = key.size();
+            int32_t value = x->value;
+            out.write((const char *) &length, sizeof(length));
+            out.write((const char *) &value, sizeof(value));
+            out.write(key.data(), key.size());
+        }
+        for (int c = 0; c < 256; c++) {
+            if (x->next[c] == nullptr) continue;
+            key.push_back((char) c);
+            save(x->next[c], key, out);
+            key.pop_back();
+        }
+    }
+
+    /**
+     * Służy do sprawdzenia czy węzeł nie przechowuje wartości i nie ma dzieci
+     *
+     * @param x - węzeł
+     * @return - true jeśli węzeł można odpiąć od rodzica i zwolnić
+     */
+    static bool isBare(const Node *x) {
+        if (x->value != 0) return false;
+        for (int c = 0; c < 256; c++)
+            if (x->next[c] != nullptr)
+                return false;
+        return true;
+    }
+
+    /**
+     * Służy do usunięcia węzła który nie przechowuje wartości i nie ma dzieci
+     *
+     * @param x - węzeł
+     * @return - węzeł x, lub null jeśli węzeł został zwolniony
+     */
+    Node *prune(Node *x) {
+        if (!isBare(x)) return x;
+        freeNode(x);
+        return nullptr;
+    }
+
+    /**
+     * Służy do sprawdzenia przed merge, intersect i subtract czy oba drzewa normalizują klucze tak samo,
+     * bo operacje te łączą węzły bez ponownego przepuszczania kluczy przez fold
+     *
+     * @param other - drugie drzewo
+     */
+    void requireSameFolding(const TRIETree &other) const {
+        if (other.folding != folding)
+            throw invalid_argument("TRIETree: trees use different folding policies");
+    }
+
+    /**
+     * Służy do zapisania zmiany obecności klucza w metodach merge, intersect i subtract
+     *
+     * @param changes - lista zmian (klucz, czy klucz jest w drzewie po zmianie), null jeśli żaden indeks nie jest włączony
+     */
+    static void record(vector<pair<string, bool>> *changes, const string &key, bool present) {
+        if (changes) changes->emplace_back(key, present);
+    }
+
+    /**
+     * Służy do zapisania zmian wszystkich kluczy poddrzewa
+     */
+    void recordSubtree(vector<pair<string, bool>> *changes, Node *x, const string &key, bool present) {
+        if (!changes) return;
+        vector<string> subtreeKeys;
+        collect(x, key, subtreeKeys);
+        for (auto &subtreeKey : subtreeKeys) changes->emplace_back(subtreeKey, present);
+    }
+
+    /**
+     * Służy do uaktualnienia indeksów i filtra kluczy po zmianach zapisanych przez merge, intersect i subtract
+     *
+     * wstawione klucze dodajemy do filtra kluczy; usunięte w nim pozostają, tak jak po del
+     */
+    void applyChanges(const vector<pair<string, bool>> &changes) {
+        for (auto &change : changes) {
+            updateIndexes(change.first, change.second);
+            if (change.second) addToLookupFilter(change.first);
+        }
+    }
+
+    /**
+     * Służy do scalenia dwóch drzew TRIE, przechodząc jednocześnie po obu drzewach
+     *
+     * @param x - węzeł drzewa do którego scalamy
+     * @param y - węzeł drzewa scalanego, po scaleniu nie należy już do niego
+     * @param policy - sposób rozstrzygania konfliktów
+     * @param key - klucz odpowiadający węzłom, bufor jest rozszerzany i skracany w miejscu
+     * @param changes - lista do której zapisujemy dodane i usunięte klucze, lub null
+     * @return - węzeł scalonego drzewa
+     *
+     * jeśli y nie istnieje zwracamy x
+     * jeśli x nie istnieje podpinamy całe poddrzewo y bez kopiowania, wszystkie jego klucze są nowe
+     * jeśli w y kończy się słowo ustalamy wartość w x zgodnie z polityką konfliktów i zapisujemy zmianę obecności klucza
+     * scalamy rekurencyjnie dzieci istniejące w y
+     * przeliczamy licznik słów i sumę wartości węzła
+     * zwalniamy węzeł y i zwracamy x (lub null jeśli x stał się pusty)
+     */
+    Node *merge(Node *x, Node *y, ConflictPolicy policy, string &key, vector<pair<string, bool>> *changes) {
+        if (y == nullptr) return x;
+        if (x == nullptr) {
+            recordSubtree(changes, y, key, true);
+            return y;
+        }
+        if (y->value != 0) {
+            bool present = x->value != 0;
+            if (x->value == 0 || policy == KEEP_THEIRS) x->value = y->value;
+            else if (policy == SUM_VALUES) x->value += y->value;
+            if (present != (x->value != 0)) record(changes, key, !present);
+        }
+        for (int c = 0; c < 256; c++) {
+            if (y->next[c] == nullptr) continue;
+            key.push_back((char) c);
+            x->next[c] = merge(x->next[c], y->next[c], policy, key, changes);
+            key.pop_back();
+        }
+        freeNode(y);
+        refresh(x);
+        return prune(x);
+    }
+
+    /**
+     * Służy do pozostawienia w drzewie tylko kluczy występujących również w drugim drzewie
+     *
+     * @param x - węzeł drzewa które modyfikujemy
+     * @param y - węzeł drugiego drzewa
+     * @param key - klucz odpowiadający węzłom, bufor jest rozszerzany i skracany w miejscu
+     * @param changes - lista do której zapisujemy usunięte klucze, lub null
+     * @return - węzeł drzewa po przecięciu
+     *
+     * jeśli x nie istnieje zwracamy null
+     * jeśli y nie istnieje całe poddrzewo x jest zwalniane
+     * jeśli w y nie kończy się słowo usuwamy wartość z x
+     * przecinamy rekurencyjnie dzieci istniejące w x
+     * przeliczamy licznik słów i sumę wartości węzła
+     */
+    Node *intersect(Node *x, Node *y, string &key, vector<pair<string, bool>> *changes) {
+        if (x == nullptr) return nullptr;
+        if (y == nullptr) {
+            recordSubtree(changes, x, key, false);
+            destroy(x);
+            return nullptr;
+        }
+        if (y->value == 0 && x->value != 0) {
+            x->value = 0;
+            record(changes, key, false);
+        }
+        for (int c = 0; c < 256; c++) {
+            if (x->next[c] == nullptr) continue;
+            key.push_back((char) c);
+            x->next[c] = intersect(x->next[c], y->next[c], key, changes);
+            key.pop_back();
+        }
+        refresh(x);
+        return prune(x);
+    }
+
+    /**
+     * Służy do usunięcia z drzewa kluczy występujących w drugim drzewie
+     *
+     * @param x - węzeł drzewa które modyfikujemy
+     * @param y - węzeł drugiego drzewa
+     * @param key - klucz odpowiadający węzłom, bufor jest rozszerzany i skracany w miejscu
+     * @param changes - lista do której zapisujemy usunięte klucze, lub null
+     * @return - węzeł drzewa po odjęciu
+     *
+     * jeśli któryś z węzłów nie istnieje poddrzewo x pozostaje bez zmian
+     * jeśli w y kończy się słowo usuwamy wartość z x
+     * odejmujemy rekurencyjnie dzieci istniejące w obu drzewach
+     * przeliczamy licznik słów i sumę wartości węzła
+     */
+    Node *subtract(Node *x, Node *y, string &key, vector<pair<string, bool>> *changes) {
+        if (x == nullptr || y == nullptr) return x;
+        if (y->value != 0 && x->value != 0) {
+            x->value = 0;
+            record(changes, key, false);
+        }
+        for (int c = 0; c < 256; c++) {
+            if (x->next[c] == nullptr || y->next[c] == nullptr) continue;
+            key.push_back((char) c);
+            x->next[c] = subtract(x->next[c], y->next[c], key, changes);
+            key.pop_back();
+        }
+        refresh(x);
+        return prune(x);
+    }
+
+public:
+    /** Służy do zwracania wartości powiązanej z kluczem z drzewa TRIE o korzeniu x
+     *
+     * @param key - słowo którego szukamy
+     * @return zwraca wartość przypisaną danemu słowu w drzewie TRIE, 0 jeśli klucz nie znajduje się w drzewie
+     *
+     * Tworzymy nowy węzeł i przypisujemy do niego wartosć zwróconą przez prywatną metodę get z argumentami(korzeń, słowo którego szukamy,
+     * indeks aktualnie przetwarzanej litery w słowie)
+        jeśli nie znaleziono klucza w drzewie zwróć 0;
+        w przeciwnym wypadku
+        zwracamy wartość odpowiadającą danemu słowu
+     */
+
+    /** Służy do zwrócenia wartości korzneia
+     *
+     * @return korzeń
+     *
+     * zwracamy korzeń
+     */
+    Node* getRoot(){
+        return root;
+    }
+
+    int get(const string &key) {
+        ReadGuard guard(*this);
+        if (filter) {
+            filterQueries.fetch_add(1, memory_order_relaxed);
+            if (!filter->mayContain(filterHash(key, folding))) {
+                filterRejected.fetch_add(1, memory_order_relaxed);
+                return 0;
+            }
+        }
+        Node *x = find(key);
+        int value = x == nullptr ? 0 : x->value;
+        if (filter && value == 0) filterFalsePositives.fetch_add(1, memory_order_relaxed);
+        return value;
+    }
+
+    /** Służy do sprawdzenia czy dany klucz znajduje się w drzewie
+     *
+     *
+     * @param key - sprawdzany klucz
+     * @return - wywołanie metody która sprawdza czy klucz znajduje się w drzewie z argumentem (klucz)
+     *
+     * zwracamy wywołanie metody get(klucz) jeśli zwraca ona wartość różną od zera.
+     * O oznacza to że klucz znajduje się w drzewie.
+     */
+    bool contains(string key) {
+        return get(key) != 0;
+    }
+
+    /** Służy do wstawiania słowa do drzewa TRIE
+     *
+     * @param key - słowo które wstawiamy
+     * @param value - indeks przypisany danemu słowu
+     *
+     * przypisujemy do korzenia wynik zwrócony przez prywatną metodę insert z argumentami(korzeń,klucz,wartość,
+     * indeks aktualnie przetwarzanej litery w słowie)
+     * klucz dopisujemy do filtra tylko gdy wcześniej go nie było, tak jak w upsert
+     *
+     */
+    void insert(string key, int value) {
+        if (folding != FOLD_NONE) key = fold(key);
+        updateIndexes(key, value != 0);
+        Aggregate delta;
+        root = insert(root, key, value, 0, delta);
+        if (delta.count > 0) addToLookupFilter(key);
+    }
+
+    /**
+     * Służy do zmiany wartości klucza funkcją poprzedniej wartości w jednym przejściu w dół drzewa
+     *
+     * @param key - klucz
+     * @param update - funkcja otrzymująca poprzednią wartość (0 jeśli klucza nie ma) i zwracająca nową (0 usuwa klucz)
+     * @return - nowa wartość klucza
+     *
+     * schodzimy po literach klucza tworząc brakujące węzły i zapamiętując ścieżkę
+     * w węźle końcowym wyliczamy nową wartość i zmianę ilości słów i sumy wartości
+     * dodajemy zmianę do liczników wszystkich węzłów na ścieżce
+     * jeśli klucz został usunięty (lub nie powstał), wracamy po ścieżce w górę i odpinamy węzły bez wartości i bez dzieci
+     */
+    template<typename Update>
+    int upsert(const string &original, Update update) {
+        string folded;
+        const string &key = folding == FOLD_NONE ? original : (folded = fold(original));
+        vector<Node *> path;
+        path.reserve(key.size() + 1);
+        Node *x = root;
+        if (x == nullptr) root = x = new Node();
+        path.push_back(x);
+        for (unsigned char c : key) {
+            if (x->next[c] == nullptr) x->next[c] = new Node();
+            x = x->next[c];
+            path.push_back(x);
+        }
+
+        int previous = x->value;
+        int value = update(previous);
+        x->value = value;
+        int count = (value != 0) - (previous != 0);
+        long long sum = (long long) value - previous;
+        for (Node *y : path) {
+            y->count += count;
+            y->sum += sum;
+        }
+        updateIndexes(key, value != 0);
+        if (value != 0 && previous == 0) addToLookupFilter(key);
+
+        if (value == 0) {
+            for (size_t d = key.size() + 1; d-- > 0 && isBare(path[d]);) {
+                if (d == 0) root = nullptr;
+                else path[d - 1]->next[(unsigned char) key[d - 1]] = nullptr;
+                freeNode(path[d]);
+            }
+        }
+        return value;
+    }
+
+    /**
+     * Służy do dodania liczby do wartości klucza, np. przy zliczaniu wystąpień słów
+     *
+     * @param key - klucz, jeśli go nie ma traktujemy jego wartość jako 0
+     * @param delta - dodawana liczba
+     * @return - nowa wartość klucza, jeśli wynosi 0 klucz został usunięty
+     */
+    int addTo(const string &key, int delta) {
+        return upsert(key, [delta](int value) { return value + delta; });
+    }
+
+    /**
+     * Służy do wstawienia klucza tylko wtedy, gdy nie ma go jeszcze w drzewie
+     *
+     * @param key - klucz
+     * @param value - wartość
+     * @return - true jeśli klucz został wstawiony
+     */
+    bool insertIfAbsent(const string &key, int value) {
+        bool inserted = false;
+        upsert(key, [&](int previous) {
+            if (previous != 0) return previous;
+            inserted = value != 0;
+            return value;
+        });
+        return inserted;
+    }
+
+    /**
+     * Służy do zmiany wartości klucza tylko wtedy, gdy ma ona oczekiwaną wartość
+     *
+     * @param key - klucz
+     * @param expected - oczekiwana wartość, 0 oznacza że klucza nie ma w drzewie
+     * @param desired - nowa wartość, 0 usuwa klucz
+     * @return - true jeśli wartość została zmieniona
+     */
+    bool compareAndSet(const string &key, int expected, int desired) {
+        bool swapped = false;
+        upsert(key, [&](int previous) {
+            if (previous != expected) return previous;
+            swapped = true;
+            return desired;
+        });
+        return swapped;
+    }
+
+    /**
+     * Wersje upsert, addTo, insertIfAbsent i compareAndSet bezpieczne przy wywołaniu z wielu wątków naraz;
+     * aktualizacje są wykonywane po kolei pod wspólną blokadą, więc nie mogą przeplatać się
+     * z innymi metodami modyfikującymi drzewo ani z odczytami
+     */
+    template<typename Update>
+    int concurrentUpsert(const string &key, Update update) {
+        lock_guard<mutex> guard(updateLock);
+        return upsert(key, update);
+    }
+
+    int concurrentAddTo(const string &key, int delta) {
+        lock_guard<mutex> guard(updateLock);
+        return addTo(key, delta);
+    }
+
+    bool concurrentInsertIfAbsent(const string &key, int value) {
+        lock_guard<mutex> guard(updateLock);
+        return insertIfAbsent(key, value);
+    }
+
+    bool concurrentCompareAndSet(const string &key, int expected, int desired) {
+        lock_guard<mutex> guard(updateLock);
+        return compareAndSet(key, expected, desired);
+    }
+
+    /** Służy do wyszukiwania najdłuższego przedrostka danego słowa
+     *
+     * @param query - łańcuch znaków dla którego szukamy najdłuższego przedrostka
+     * @param value - jeśli nie jest null, zapisujemy w nim wartość znalezionego przedrostka (0 gdy go nie ma)
+     * @return - najdłuższy pasujący przedrostek odpowiadający danemu słowu
+     *
+     * długość najdłuższego pasującego przedrostku = wynik metody longestPrefixOf z argumentami
+     * (korzeń, łańcuch znaków dla którego szukamy najdłuższego przedrostka, 0, 0, wartość);
+        zwracamy najdłuższy prefiks pasujący dla danego słowa
+     */
+    string longestPrefixOf(const string &query, int *value = nullptr) {
+        ReadGuard guard(*this);
+        int found = 0;
+        size_t length = 0;
+        if (folding != FOLD_NONE) {
+            Node *x = root;
+            FoldedKey cursor(query, folding);
+            unsigned char c;
+            for (;;) {
+                if (x == nullptr) break;
+                if (x->value != 0 && cursor.boundary()) {
+                    length = cursor.position;
+                    found = x->value;
+                }
+                if (!cursor.next(c)) break;
+                x = x->next[c];
+            }
+        } else {
+            length = longestPrefixOf(root, query, 0, 0, found);
+        }
+        if (value) *value = found;
+        return query.substr(0, length);
+    }
+
+    /**
+     * Służy do podziału tekstu na tokeny metodą najdłuższego dopasowania (maximal munch)
+     *
+     * @param data - tekst
+     * @param length - długość tekstu
+     * @param callback - wywoływany dla każdego tokenu z argumentami (pozycja, długość, wartość klucza)
+     * @param policy - sposób obsługi bajtów które nie rozpoczynają żadnego klucza
+     *
+     * od aktualnej pozycji szukamy najdłuższego pasującego klucza
+     * jeśli istnieje zgłaszamy go i przesuwamy się za niego
+     * w przeciwnym wypadku obsługujemy bajt zgodnie z polityką i przesuwamy się o jeden bajt
+     */
+    template<typename Callback>
+    void tokenize(const char *data, size_t length, Callback callback, UnmatchedPolicy policy = EMIT_RUNS) {
+        ReadGuard guard(*this);
+        TokenEmitter<Callback> emitter(callback, policy);
+        size_t position = 0;
+        while (position < length) {
+            size_t matched;
+            int value;
+            longestMatch(data + position, length - position, true, matched, value);
+            if (matched > 0) {
+                emitter.match(position, matched, value);
+                position += matched;
+            } else {
+                emitter.unmatched(position);
+                position++;
+            }
+        }
+        emitter.finish();
+    }
+
+    /**
+     * Służy do podziału strumienia na tokeny metodą najdłuższego dopasowania, w jednym przebiegu
+     *
+     * @param in - strumień wejściowy
+     * @param callback - wywoływany dla każdego tokenu z argumentami (pozycja w strumieniu, długość, wartość klucza)
+     * @param policy - sposób obsługi bajtów które nie rozpoczynają żadnego klucza
+     * @param chunkSize - rozmiar okna do którego wczytujemy strumień
+     *
+     * strumień czytamy porcjami do jednego okna, powiększanego tylko gdy pojedyncze dopasowanie jest dłuższe niż okno
+     * jeśli dopasowanie dochodzi do końca okna, przesuwamy nieprzetworzoną resztę na początek okna,
+     * doczytujemy kolejną porcję i ponawiamy dopasowanie od początku tokenu
+     */
+    template<typename Callback>
+    void tokenize(istream &in, Callback callback, UnmatchedPolicy policy = EMIT_RUNS, size_t chunkSize = 65536) {
+        ReadGuard guard(*this);
+        TokenEmitter<Callback> emitter(callback, policy);
+        vector<char> window(max(chunkSize, (size_t) 1));
+        size_t base = 0, begin = 0, filled = 0;
+        bool eof = false;
+        for (;;) {
+            size_t matched = 0;
+            int value = 0;
+            if (begin == filled && eof) break;
+            if (begin == filled || !longestMatch(&window[begin], filled - begin, eof, matched, value)) {
+                copy(window.begin() + begin, window.begin() + filled, window.begin());
+                base += begin;
+                filled -= begin;
+                begin = 0;
+                if (filled == window.size()) window.resize(window.size() * 2);
+                in.read(&window[filled], window.size() - filled);
+                filled += in.gcount();
+                eof = !in;
+                continue;
+            }
+            if (matched > 0) {
+                emitter.match(base + begin, matched, value);
+                begin += matched;
+            } else {
+                emitter.unmatched(base + begin);
+                begin++;
+            }
+        }
+        emitter.finish();
+    }
+
+    /** Służy do zwracania wszystkich kluczy dla których prefiksem jest puste słowo
+     *
+     * @return - wszystkie klucze dla których prefiksem jest puste słowo
+     * czyli wszystkie klucze z drzewa
+     *
+     * zwracamy wartość zwróconą przez metodę keysWithPrefix z argumentem(puste słowo);
+     */
+    vector<string> keys() {
+        return keysWithPrefix("");
+    }
+
+    /** Służy do zebrania wszystkich słów pasujących do danego przedrostka w jednym wektorze
+     *
+     * @param prefix - dany przedrostek
+     * @return - zwracamy kolekcję kluczy z danym przedrostkiem
+     *
+     * utworzenie wektora
+        utworzenie nowego węzła i przypisanie do niego wartośći zwracanej przez prywatną metodę get z argumentami(korzeń, przedrostek, 0)
+        zebranie do kolekcji wszystkich słów pasujących do danego przedrostka - wywołanie prywatnej metody collect z argumentami(aktualnie przetwarzany węzeł,przedrostek,wektor)
+        zwracamy wektor słów pasujących do danego przedrostka
+     */
+    vector<string> keysWithPrefix(string prefix) {
+        ReadGuard guard(*this);
+        vector<string> queue;
+        if (folding != FOLD_NONE) {
+            string canonical;
+            Node *x = find(prefix, &canonical);
+            collect(x, canonical, queue);
+            return queue;
+        }
+        Node *x = get(root, prefix, 0);
+        collect(x, prefix, queue);
+        return queue;
+    }
+
+    /**
+     * Służy do przejścia wszystkich par klucz-wartość z danym przedrostkiem, w porządku leksykograficznym
+     *
+     * @param prefix - przedrostek
+     * @param visitor - funkcja wywoływana z argumentami (const string &klucz, int &wartość), zwraca false aby przerwać
+     * przechodzenie; klucz jest wspólnym buforem ważnym tylko w trakcie wywołania, a wartość można zmienić w miejscu
+     * (poza ustawieniem 0, które nie zwolni węzłów)
+     * @return - true jeśli odwiedzono wszystkie klucze, false jeśli funkcja odwiedzająca przerwała przechodzenie
+     *
+     * schodzimy do węzła przedrostka i przechodzimy jego poddrzewo raz, bez kopiowania kluczy i ponownego wyszukiwania wartości
+     */
+    template<typename Visitor>
+    bool forEach(string prefix, Visitor visitor) {
+        ReadGuard guard(*this);
+        if (folding != FOLD_NONE) prefix = fold(prefix);
+        Aggregate delta;
+        Node *x = get(root, prefix, 0);
+        bool completed = forEach(x, prefix, visitor, delta);
+        if (delta.count != 0 || delta.sum != 0) {
+            Node *y = root;
+            for (size_t d = 0; d < prefix.size(); d++) {
+                y->count += delta.count;
+                y->sum += delta.sum;
+                y = y->next[(unsigned char) prefix[d]];
+            }
+        }
+        return completed;
+    }
+
+    /**
+     * Służy do równoległego zebrania kluczy z danym przedrostkiem
+     *
+     * @param prefix - przedrostek
+     * @param threads - ilość wątków, 0 oznacza ilość rdzeni procesora
+     * @return - klucze w porządku leksykograficznym, tak jak w keysWithPrefix
+     *
+     * każde poddrzewo zbiera klucze do własnego wektora, a wektory łączymy w kolejności poddrzew
+     */
+    vector<string> parallelKeysWithPrefix(string prefix, int threads = 0) {
+        ReadGuard guard(*this);
+        if (folding != FOLD_NONE) prefix = fold(prefix);
+        vector<Subtree> tasks;
+        splitSubtrees(get(root, prefix, 0), prefix, PARALLEL_LEVELS, tasks);
+        vector<vector<string>> parts(tasks.size());
+        parallelVisit(tasks, threads, [&parts](size_t task, const string &key, int &) {
+            parts[task].push_back(key);
+        });
+        size_t total = 0;
+        for (auto &part : parts) total += part.size();
+        vector<string> queue;
+        queue.reserve(total);
+        for (auto &part : parts)
+            for (auto &key : part)
+                queue.push_back(move(key));
+        return queue;
+    }
+
+    vector<string> parallelKeys(int threads = 0) {
+        return parallelKeysWithPrefix("", threads);
+    }
+
+    /**
+     * Służy do policzenia słów w drzewie, zachowana dla zgodności z pozostałymi metodami równoległymi
+     *
+     * licznik słów jest utrzymywany w korzeniu, więc odczyt jest natychmiastowy i nie wymaga wątków
+     *
+     * @param threads - ignorowany
+     * @return - ilość słów w drzewie
+     */
+    int parallelSize(int threads = 0) {
+        (void) threads;
+        return size();
+    }
+
+    /**
+     * Służy do równoległego wyeksportowania par klucz-wartość w formacie "klucz\twartość", po jednej w wierszu
+     *
+     * @param out - strumień wyjściowy
+     * @param prefix - przedrostek eksportowanych kluczy
+     * @param threads - ilość wątków, 0 oznacza ilość rdzeni procesora
+     *
+     * każde poddrzewo formatuje swoje wiersze do własnego bufora, bufory zapisujemy w kolejności poddrzew
+     */
+    void parallelExport(ostream &out, string prefix = "", int threads = 0) {
+        ReadGuard guard(*this);
+        if (folding != FOLD_NONE) prefix = fold(prefix);
+        vector<Subtree> tasks;
+        splitSubtrees(get(root, prefix, 0), prefix, PARALLEL_LEVELS, tasks);
+        vector<string> parts(tasks.size());
+        parallelVisit(tasks, threads, [&parts](size_t task, const string &key, int &value) {
+            parts[task].append(key);
+            parts[task].push_back('\t');
+            parts[task].append(to_string(value));
+            parts[task].push_back('\n');
+        });
+        for (auto &part : parts)
+            out.write(part.data(), part.size());
+    }
+
+    /**
+     * Wyszykuje słowa pasujące do danego wzorca, znakiem "." można zastąpić dowolny znak
+     *
+     * @param pat - wzorzec
+     * @return - kolekcja słow pasujących do wzorca
+     *
+     * utworzenie wektora
+       wywołanie metody której zadaniem jest dodanie do kolekcji wszystkich słow pasujących do danego wzorca z argumentami
+       (korzeń, "", prefiks, kolekcja do której zostanie wstawione pasujące słowo)
+       zwracamy wektor pasujących słów
+     */
+    vector<string> keysThatMatch(string pat) {
+        ReadGuard guard(*this);
+        if (folding != FOLD_NONE) pat = fold(pat);
+        vector<string> q;
+        collect(root, "", pat, q);
+        return q;
+    }
+
+    /**
+     * Służy do zapisywania klucza w metodzie keysThatMatch
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param prefix - szukany przedrostek
+     * @param pat - wzorzec
+     * @param q - kolekcja do której zostanie wstawione odpowiednie słowo
+     *
+     * jeśli węzeł który aktualnie przetwarzamy jest pusty przerywamy pracę metody
+        jeśli długość prefiksu jest równa długości wzorca oraz wartość w węźle który aktualnie przetwarzamy nie jest równa 0
+        wstawiany do wektora aktualny prefiks
+        jeśli długość przedrostka jest równa długości wzorca przerywamy pracę metody
+        deklaracja następnej litery w słowie oraz przypisanie do niej następnego znaku wzorca
+        przechodzimy przez cały alfabet w danym węźle
+            jeśli następny znak w danym słowie jest równy "." albo jest równy znakowi na danej pozycji we wzorcu
+                wywołujemy metodę collect z argumentami (węzeł[następny poziom],prefiks + znak na danej pozycji we wzorcu,
+                wzorzec, kolekcja) wstawiającą dany klucz do kolekcji
+     *
+     */
+    void collect(Node *x, string prefix, string pat, vector<string> &q) {
+        if (x == nullptr) return;
+        if (prefix.length() == pat.length() && x->value != 0) q.push_back(prefix);
+        if (prefix.length() == pat.length()) return;
+        unsigned char next = pat[prefix.length()];
+        for (int c = 0; c < 256; c++)
+            if (next == '.' || next == c)
+                collect(x->next[c], prefix + (char) c, pat, q);
+    }
+
+    /**
+     * Służy do usuwania danego klucza z drzewa
+     *
+     * @param key - klucz
+     *
+     * przypisanie do korzenia wartości zwróconych przez metodę del z argumentami (korzeń,klucz,0)
+     *
+     */
+    void del(string key) {
+        if (folding != FOLD_NONE) key = fold(key);
+        updateIndexes(key, false);
+        Aggregate delta;
+        root = del(root, key, 0, delta);
+    }
+
+    /**
+     * Służy do usunięcia wszystkich kluczy zaczynających się od danego przedrostka
+     *
+     * @param prefix - przedrostek
+     * @return - ilość usuniętych kluczy
+     *
+     * schodzimy do węzła przedrostka zapamiętując ścieżkę
+     * jeśli węzeł nie istnieje nie ma czego usuwać
+     * odpinamy poddrzewo od rodzica jednym przypisaniem, odejmujemy jego licznik i sumę od przodków i zwalniamy je
+     * wracamy po ścieżce w górę i usuwamy przodków którzy nie przechowują wartości i nie mają już dzieci,
+     * zatrzymując się na pierwszym przodku który musi pozostać
+     */
+    int deletePrefix(string prefix) {
+        if (folding != FOLD_NONE) prefix = fold(prefix);
+        vector<Node *> path;
+        Node *x = root;
+        for (size_t d = 0; x != nullptr && d < prefix.length(); d++) {
+            path.push_back(x);
+            x = x->next[(unsigned char) prefix[d]];
+        }
+        if (x == nullptr) return 0;
+
+        if (path.empty()) root = nullptr;
+        else path.back()->next[(unsigned char) prefix[path.size() - 1]] = nullptr;
+        for (Node *y : path) {
+            y->count -= x->count;
+            y->sum -= x->sum;
+        }
+        if (suffixes || reversed) {
+            vector<string> removedKeys;
+            collect(x, prefix, removedKeys);
+            for (auto &key : removedKeys) updateIndexes(key, false);
+        }
+        int removed = destroy(x);
+
+        for (int d = (int) path.size() - 1; d >= 0; d--) {
+            if (prune(path[d]) != nullptr) break;
+            if (d == 0) root = nullptr;
+            else path[d - 1]->next[(unsigned char) prefix[d - 1]] = nullptr;
+        }
+        return removed;
+    }
+
+    /**
+     * Służy do scalenia innego drzewa z tym drzewem
+     *
+     * Poddrzewa występujące tylko w drzewie other są podpinane w całości, bez ponownego wstawiania ich kluczy,
+     * więc koszt jest proporcjonalny do części wspólnej obu drzew. Węzły drzewa other są przejmowane - po scaleniu jest ono puste.
+     * Jeśli włączony jest indeks sufiksowy, drzewo odwróconych kluczy lub filtr kluczy, są one uaktualniane tylko
+     * o klucze dodane lub usunięte przez scalenie, co dokłada koszt proporcjonalny do ilości tych kluczy.
+     *
+     * @param other - drzewo scalane
+     * @param policy - sposób rozstrzygania konfliktów gdy klucz występuje w obu drzewach
+     * @throws invalid_argument - jeśli drzewa normalizują klucze w różny sposób
+     */
+    void merge(TRIETree &other, ConflictPolicy policy) {
+        if (&other == this) return;
+        requireSameFolding(other);
+        regions.insert(regions.end(), other.regions.begin(), other.regions.end());
+        other.regions.clear();
+        vector<pair<string, bool>> changes;
+        string key;
+        root = merge(root, other.root, policy, key, suffixes || reversed || filter ? &changes : nullptr);
+        other.root = nullptr;
+        applyChanges(changes);
+        other.rebuildIndexes();
+    }
+
+    /**
+     * Służy do pozostawienia w drzewie tylko kluczy występujących również w drzewie other
+     *
+     * Włączone indeksy są uaktualniane tylko o usunięte klucze.
+     *
+     * @param other - drugie drzewo, nie jest modyfikowane
+     * @throws invalid_argument - jeśli drzewa normalizują klucze w różny sposób
+     */
+    void intersect(TRIETree &other) {
+        if (&other == this) return;
+        requireSameFolding(other);
+        vector<pair<string, bool>> changes;
+        string key;
+        root = intersect(root, other.root, key, suffixes || reversed ? &changes : nullptr);
+        applyChanges(changes);
+    }
+
+    /**
+     * Służy do usunięcia z drzewa wszystkich kluczy występujących w drzewie other
+     *
+     * Włączone indeksy są uaktualniane tylko o usunięte klucze.
+     *
+     * @param other - drugie drzewo, nie jest modyfikowane
+     * @throws invalid_argument - jeśli drzewa normalizują klucze w różny sposób
+     */
+    void subtract(TRIETree &other) {
+        if (&other == this) {
+            destroy(root);
+            root = nullptr;
+            rebuildIndexes();
+            return;
+        }
+        requireSameFolding(other);
+        vector<pair<string, bool>> changes;
+        string key;
+        root = subtract(root, other.root, key, suffixes || reversed ? &changes : nullptr);
+        applyChanges(changes);
+    }
+
+    /**
+     * Służy do włączenia indeksu sufiksowego, indeks jest budowany z aktualnych kluczy
+     * i od tej chwili aktualizowany przez insert i del
+     */
+    void enableSuffixIndex() {
+        if (!suffixes) suffixes.reset(new SuffixIndex());
+        rebuildSuffixIndex();
+    }
+
+    void disableSuffixIndex() {
+        suffixes.reset();
+    }
+
+    /**
+     * Służy do włączenia drzewa odwróconych kluczy, budowanego z aktualnych kluczy i od tej chwili
+     * aktualizowanego przez insert i del; zapytania o przyrostki są w nim zapytaniami o przedrostki
+     */
+    void enableReverseIndex() {
+        if (!reversed) reversed.reset(new TRIETree());
+        rebuildReverseIndex();
+    }
+
+    void disableReverseIndex() {
+        reversed.reset();
+    }
+
+    /**
+     * Służy do zebrania kluczy kończących się danym przyrostkiem, np. ".example.com"
+     *
+     * @param suffix - przyrostek
+     * @return - klucze z danym przyrostkiem, w porządku leksykograficznym odwróconych kluczy
+     *
+     * jeśli drzewo odwróconych kluczy jest włączone zbieramy z niego klucze z odwróconym przyrostkiem jako przedrostkiem
+     * i odwracamy je z powrotem, koszt jak w keysWithPrefix
+     * w przeciwnym wypadku sprawdzamy kolejno wszystkie klucze
+     */
+    vector<string> keysWithSuffix(string suffix) {
+        if (folding != FOLD_NONE) suffix = fold(suffix);
+        vector<string> queue;
+        if (reversed) {
+            queue = reversed->keysWithPrefix(string(suffix.rbegin(), suffix.rend()));
+            for (auto &key : queue) reverse(key.begin(), key.end());
+            return queue;
+        }
+        for (auto &key : keys())
+            if (key.size() >= suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0)
+                queue.push_back(key);
+        sort(queue.begin(), queue.end(), [](const string &a, const string &b) {
+            return lexicographical_compare(a.rbegin(), a.rend(), b.rbegin(), b.rend(), [](char x, char y) {
+                return (unsigned char) x < (unsigned char) y;
+            });
+        });
+        return queue;
+    }
+
+    /**
+     * Służy do wyszukiwania najdłuższego klucza będącego przyrostkiem danego słowa
+     *
+     * @param query - łańcuch znaków dla którego szukamy najdłuższego przyrostka
+     * @return - najdłuższy przyrostek będący kluczem (w trybie składania wielkości liter w postaci kanonicznej)
+     *
+     * jeśli drzewo odwróconych kluczy jest włączone szukamy w nim najdłuższego przedrostka odwróconego słowa
+     * w przeciwnym wypadku sprawdzamy kolejne przyrostki od najdłuższego
+     */
+    string longestSuffixOf(string query) {
+        if (folding != FOLD_NONE) query = fold(query);
+        if (reversed) {
+            size_t length = reversed->longestPrefixOf(string(query.rbegin(), query.rend())).size();
+            return query.substr(query.size() - length);
+        }
+        for (size_t i = 0; i < query.size(); i++)
+            if (contains(query.substr(i)))
+                return query.substr(i);
+        return "";
+    }
+
+    /**
+     * Służy do włączenia filtra kluczy przed metodami get i contains; zapytania o klucze których na pewno nie ma
+     * w drzewie są odrzucane bez przeszukiwania drzewa
+     *
+     * @param bitsPerKey - ilość bitów filtra na klucz, 10 bitów daje około 1% fałszywych trafień
+     */
+    void enableLookupFilter(int bitsPerKey = 10) {
+        filterBitsPerKey = bitsPerKey;
+        filterQueries = 0;
+        filterRejected = 0;
+        filterFalsePositives = 0;
+        filter.reset(new LookupFilter(0, bitsPerKey));
+        rebuildLookupFilter();
+    }
+
+    void disableLookupFilter() {
+        filter.reset();
+    }
+
+    /**
+     * Służy do przebudowania filtra kluczy z aktualnych kluczy drzewa
+     *
+     * Filtr jest aktualizowany przez insert, ale usunięte klucze pozostają w nim i zwiększają ilość fałszywych trafień,
+     * dlatego po większej ilości usunięć należy go przebudować
+     *
+     * nowy filtr ma pojemność dwukrotnie większą od ilości kluczy, żeby kolejne wstawienia nie wymuszały przebudowy
+     */
+    void rebuildLookupFilter() {
+        if (!filter) return;
+        filter.reset(new LookupFilter(max(2 * (size_t) size(), (size_t) 64), filterBitsPerKey));
+        forEach("", [this](const string &key, int &) {
+            filter->add(filterHash(key, FOLD_NONE));
+            return true;
+        });
+    }
+
+    /**
+     * Służy do zwrócenia statystyk filtra kluczy od chwili jego włączenia
+     *
+     * @return - statystyki; hitRate to część zapytań odrzuconych przez filtr,
+     * falsePositiveRate to część zapytań o nieistniejące klucze, których filtr nie odrzucił
+     */
+    LookupFilterStats lookupFilterStats() const {
+        LookupFilterStats stats;
+        stats.queries = filterQueries.load();
+        stats.rejected = filterRejected.load();
+        stats.falsePositives = filterFalsePositives.load();
+        if (stats.queries != 0) stats.hitRate = (double) stats.rejected / stats.queries;
+        if (stats.rejected + stats.falsePositives != 0)
+            stats.falsePositiveRate = (double) stats.falsePositives / (stats.rejected + stats.falsePositives);
+        return stats;
+    }
+
+    /**
+     * Służy do wyszukania kluczy zawierających dany podciąg
+     *
+     * @param pattern - szukany podciąg
+     * @return - klucze zawierające podciąg, w porządku leksykograficznym
+     *
+     * jeśli indeks sufiksowy jest włączony korzystamy z niego
+     * w przeciwnym wypadku sprawdzamy kolejno wszystkie klucze
+     */
+    vector<string> keysContaining(string pattern) {
+        if (folding != FOLD_NONE) pattern = fold(pattern);
+        if (suffixes) return suffixes->keysContaining(pattern);
+        vector<string> queue;
+        for (auto &key : keys())
+            if (key.find(pattern) != string::npos)
+                queue.push_back(key);
+        return queue;
+    }
+
+    /**
+     * Służy do przeniesienia wszystkich węzłów do jednego ciągłego obszaru pamięci w kolejności przechodzenia drzewa
+     *
+     * Górne BFS_LEVELS poziomy układamy wszerz (są odwiedzane przez każde wyszukiwanie), a poddrzewa poniżej nich
+     * w głąb, więc ścieżka od korzenia do liścia dotyka kolejnych, bliskich sobie węzłów zamiast stron rozrzuconych po stercie.
+     * Nowa kopia budowana jest wyłącznie przez odczyt starych węzłów, a korzeń podmieniany atomowo, dlatego compact
+     * może działać w wątku konserwacyjnym równolegle z odczytami. Stare węzły zwalniamy dopiero gdy zakończą się
+     * wszystkie odczyty zarejestrowane przed podmianą korzenia (ReadGuard). compact trzyma updateLock, więc metody
+     * concurrent* czekają na jego zakończenie; pozostałe zapisy (również forEach zmieniający wartości) muszą być
+     * z compact synchronizowane zewnętrznie.
+     *
+     * @return - ilość przeniesionych węzłów
+     *
+     * liczymy węzły i rezerwujemy obszar
+     * układamy kolejne węzły w obszarze, ustawiając wskaźnik w nowym rodzicu w chwili umieszczenia dziecka
+     * podmieniamy korzeń i czekamy na odczyty które mogły widzieć stary korzeń
+     * zwalniamy stare węzły spoza obszarów oraz same stare obszary
+     */
+    size_t compact() {
+        lock_guard<mutex> exclusive(updateLock);
+        Node *old = root;
+        vector<Node *> stack;
+        size_t count = 0;
+        if (old != nullptr) stack.push_back(old);
+        while (!stack.empty()) {
+            Node *x = stack.back();
+            stack.pop_back();
+            count++;
+            for (int c = 0; c < 256; c++)
+                if (x->next[c] != nullptr)
+                    stack.push_back(x->next[c]);
+        }
+        if (count == 0) return 0;
+
+        Node *region = new Node[count];
+        size_t used = 0;
+        Node *compacted = nullptr;
+        vector<Node *> retired;
+        retired.reserve(count);
+        vector<pair<Node *, Node **>> level = {{old, &compacted}};
+        auto place = [&](const pair<Node *, Node **> &pending) {
+            Node *y = &region[used++];
+            y->value = pending.first->value;
+            y->count = pending.first->count;
+            y->sum = pending.first->sum;
+            for (int c = 0; c < 256; c++) y->next[c] = nullptr;
+            *pending.second = y;
+            retired.push_back(pending.first);
+            return y;
+        };
+        for (int depth = 0; depth < BFS_LEVELS && !level.empty(); depth++) {
+            vector<pair<Node *, Node **>> nextLevel;
+            for (auto &pending : level) {
+                Node *y = place(pending);
+                for (int c = 0; c < 256; c++)
+                    if (pending.first->next[c] != nullptr)
+                        nextLevel.emplace_back(pending.first->next[c], &y->next[c]);
+            }
+            level.swap(nextLevel);
+        }
+        for (auto &subtree : level) {
+            vector<pair<Node *, Node **>> pending = {subtree};
+            while (!pending.empty()) {
+                auto top = pending.back();
+                pending.pop_back();
+                Node *y = place(top);
+                for (int c = 255; c >= 0; c--)
+                    if (top.first->next[c] != nullptr)
+                        pending.emplace_back(top.first->next[c], &y->next[c]);
+            }
+        }
+
+        root = compacted;
+        waitForReaders();
+        less<Node *> before;
+        auto inRegion = [&](Node *x) {
+            for (auto &r : regions)
+                if (!before(x, r.first) && before(x, r.first + r.second))
+                    return true;
+            return false;
+        };
+        for (Node *x : retired)
+            if (!inRegion(x))
+                delete x;
+        for (auto &r : regions) delete[] r.first;
+        regions.assign(1, make_pair(region, count));
+        return count;
+    }
+
+    /**
+     * Konstruktor domyślny,
+     *
+     * Utworzenie struktury przechowującej wartość oraz alfabet
+     * Przypisanie do korzenia wartości null
+     *
+     */
+    TRIETree() {
+        Node *node;
+        this->root = nullptr;
+    }
+
+    /**
+     * Służy do utworzenia drzewa w trybie składania wielkości liter
+     *
+     * @param folding - sposób składania; klucze są przechowywane w postaci kanonicznej (małymi literami),
+     * a zapytania w dowolnej wielkości liter są składane w trakcie przechodzenia drzewa, bez tworzenia nowych łańcuchów
+     */
+    explicit TRIETree(FoldPolicy folding) : TRIETree() {
+        this->folding = folding;
+    }
+
+    TRIETree(const TRIETree &) = delete;
+    TRIETree &operator=(const TRIETree &) = delete;
+
+    /**
+     * Destruktor, zwalnia wszystkie węzły drzewa oraz obszary utworzone przez compact
+     */
+    ~TRIETree() {
+        destroy(root);
+        for (auto &region : regions) delete[] region.first;
+    }
+
+    /**
+     * Służy do zwracania ilości słów w drzewie
+     *
+     * @return zwraca ilość słów w drzewie
+     *
+     * zwracamy wartość zwracaną przez prywatną metodę size z argumentem (korzeń) -  size(root), koszt O(1)
+     */
+    int size() {
+        ReadGuard guard(*this);
+        return size(root);
+    }
+
+    /**
+     * Służy do policzenia kluczy zaczynających się od danego przedrostka
+     *
+     * @param prefix - przedrostek
+     * @return - ilość kluczy z danym przedrostkiem
+     *
+     * schodzimy do węzła przedrostka i zwracamy jego licznik słów, koszt O(|prefix|)
+     */
+    int countWithPrefix(string prefix) {
+        ReadGuard guard(*this);
+        return size(find(prefix));
+    }
+
+    /**
+     * Służy do znalezienia k-tego klucza w porządku leksykograficznym
+     *
+     * @param k - numer klucza, licząc od 0
+     * @return - k-ty klucz
+     *
+     * zaczynamy od korzenia
+     * jeśli w węźle kończy się słowo, jest ono najmniejszym kluczem poddrzewa - zwracamy je gdy k = 0, w przeciwnym wypadku zmniejszamy k
+     * przechodzimy dzieci w kolejności alfabetu pomijając te, których licznik słów nie przekracza k (zmniejszając k o ten licznik)
+     * schodzimy do dziecka w którym leży k-ty klucz
+     */
+    string select(int k) {
+        ReadGuard guard(*this);
+        if (k < 0 || k >= size()) throw out_of_range("TRIETree::select: index out of range");
+        string key;
+        Node *x = root;
+        for (;;) {
+            if (x->value != 0) {
+                if (k == 0) return key;
+                k--;
+            }
+            for (int c = 0; c < 256; c++) {
+                Node *child = x->next[c];
+                if (child == nullptr) continue;
+                if (k < child->count) {
+                    key.push_back((char) c);
+                    x = child;
+                    break;
+                }
+                k -= child->count;
+            }
+        }
+    }
+
+    /**
+     * Służy do wyznaczenia pozycji klucza w porządku leksykograficznym
+     *
+     * @param key - klucz, nie musi znajdować się w drzewie
+     * @return - ilość kluczy mniejszych od key
+     *
+     * schodzimy po literach klucza
+     * w każdym węźle na ścieżce doliczamy słowo kończące się w węźle (jest przedrostkiem key, więc jest mniejsze)
+     * oraz liczniki słów dzieci odpowiadających literom mniejszym od kolejnej litery klucza
+     */
+    int rank(string key) {
+        ReadGuard guard(*this);
+        int counter = 0;
+        Node *x = root;
+        FoldedKey cursor(key, folding);
+        unsigned char next;
+        while (x != nullptr && cursor.next(next)) {
+            if (x->value != 0) counter++;
+            for (int c = 0; c < next; c++)
+                counter += size(x->next[c]);
+            x = x->next[next];
+        }
+        return counter;
+    }
+
+    /**
+     * Służy do wylosowania klucza, każdy klucz z tym samym prawdopodobieństwem
+     *
+     * @param generator - generator liczb losowych, np. mt19937
+     * @return - wylosowany klucz, pusty napis gdy drzewo jest puste
+     */
+    template<typename Generator>
+    string randomKey(Generator &generator) {
+        int n = size();
+        if (n == 0) return "";
+        uniform_int_distribution<int> index(0, n - 1);
+        return select(index(generator));
+    }
+
+    /**
+     * Służy do zsumowania wartości kluczy zaczynających się od danego przedrostka
+     *
+     * @param prefix - przedrostek
+     * @return - suma wartości kluczy z danym przedrostkiem
+     *
+     * schodzimy do węzła przedrostka i zwracamy jego sumę wartości, koszt O(|prefix|)
+     */
+    long long sumWithPrefix(string prefix) {
+        ReadGuard guard(*this);
+        Node *x = find(prefix);
+        if (x == nullptr) return 0;
+        return x->sum;
+    }
+
+    /**
+     * Służy do zapisania migawki drzewa do strumienia binarnego
+     *
+     * @param out - strumień binarny
+     *
+     * zapisujemy nagłówek, następnie rekordy (długość klucza, wartość, klucz) w porządku leksykograficznym
+     * i znacznik końca w miejscu długości klucza
+     */
+    void save(ostream &out) {
+        ReadGuard guard(*this);
+        out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        string key;
+        save(root, key, out);
+        uint32_t end = SNAPSHOT_END;
+        out.write((const char *) &end, sizeof(end));
+    }
+
+    /**
+     * Służy do wczytania migawki zapisanej metodą save
+     *
+     * @param in - strumień binarny
+     * @return - false jeśli strumień nie zawiera kompletnej migawki
+     *
+     * sprawdzamy nagłówek
+     * wczytujemy rekordy i wstawiamy je do drzewa aż do znacznika końca
+     */
+    bool load(istream &in) {
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        if (!in.read(magic, sizeof(magic)) || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) return false;
+        for (;;) {
+            uint32_t length;
+            int32_t value;
+            if (!in.read((char *) &length, sizeof(length))) return false;
+            if (length == SNAPSHOT_END) return true;
+            if (!in.read((char *) &value, sizeof(value))) return false;
+            string key(length, '\0');
+            if (!in.read(&key[0], length)) return false;
+            insert(key, value);
+        }
+    }
+
+    /**
+     * Służy do wyświetlenia wszystkich kluczy w drzewie
+     *
+     * @param out - strumień wyjściowy na który zostaną wysłane dane
+     * @param t - obiekt klasy TRIETree, którego klucze mamy za zadanie wyświetlić
+     * @return - strumień wyjściowy
+     *
+     * dla każdego klucza w obiekcie t (przechodząc drzewo metodą forEach, bez kopiowania kluczy)
+            przekierowujemy na strumień wyjściowy dany klucz
+        zwracamy strumień wyjściowy
+     */
+    friend ostream &operator<<(std::ostream &out, TRIETree &t) {
+        t.forEach("", [&out](const string &key, int &) {
+            out << key << endl;
+            return true;
+        });
+        return out;
+    }
+    /**
+     * Służy do sprawdzenia czy drzewo jest puste
+     *
+     * @return - czy drzewo jest puste
+     *
+     * jeśli rozmiar = 0 zwracamy true
+     * w przeciwnym wypadku false
+     */
+    bool isEmpty(){
+        if (size() == 0) return true;
+        return false;
+    }
+};
+
+/**
+ * Węzeł trwałego (persystentnego) drzewa TRIE
+ *
+ * Węzły są współdzielone pomiędzy wersjami drzewa, dlatego każdy z nich posiada licznik referencji
+ * (wersje drzewa oraz węzły rodziców które na niego wskazują). Węzeł zwalniamy gdy licznik spadnie do 0.
+ */
+struct PersistentNode {
+    int value = 0;
+    atomic<int> refs{1};
+    struct PersistentNode *next[256];
+};
+
+/**
+ * Trwałe drzewo TRIE - każda modyfikacja zwraca nową wersję drzewa, a poprzednie wersje pozostają niezmienione
+ *
+ * insert i del kopiują wyłącznie węzły leżące na ścieżce klucza (path copying), pozostałe poddrzewa są współdzielone
+ * z poprzednią wersją. Dzięki temu snapshot() kosztuje O(1), a stara wersja jest zwalniana przez liczniki referencji
+ * w momencie gdy ostatni czytelnik przestanie jej używać. Liczniki są atomowe, więc wersje można przekazywać między wątkami.
+ */
+class PersistentTRIETree {
+private:
+    PersistentNode *root;
+
+    explicit PersistentTRIETree(PersistentNode *root) : root(root) {}
+
+    /**
+     * Służy do zwiększenia licznika referencji węzła
+     *
+     * @param x - węzeł
+     * @return - ten sam węzeł
+     */
+    static PersistentNode *retain(PersistentNode *x) {
+        if (x != nullptr) x->refs.fetch_add(1, memory_order_relaxed);
+        return x;
+    }
+
+    /**
+     * Służy do zmniejszenia licznika referencji węzła
+     *
+     * @param x - węzeł
+     *
+     * jeśli licznik spadł do 0
+     *  zwalniamy rekurencyjnie wszystkie dzieci węzła
+     *  usuwamy węzeł
+     */
+    static void release(PersistentNode *x) {
+        if (x == nullptr) return;
+        if (x->refs.fetch_sub(1, memory_order_acq_rel) != 1) return;
+        for (int c = 0; c < 256; c++)
+            release(x->next[c]);
+        delete x;
+    }
+
+    /**
+     * Służy do skopiowania węzła leżącego na ścieżce modyfikowanego klucza
+     *
+     * @param x - kopiowany węzeł, może być null
+     * @param skip - litera której dziecka nie kopiujemy, bo zostanie zastąpione przez wywołującego
+     * @return - nowy węzeł współdzielący dzieci z węzłem x
+     */
+    static PersistentNode *copy(PersistentNode *x, int skip) {
+        PersistentNode *y = new PersistentNode();
+        if (x == nullptr) return y;
+        y->value = x->value;
+        for (int c = 0; c < 256; c++)
+            if (c != skip)
+                y->next[c] = retain(x->next[c]);
+        return y;
+    }
+
+    static PersistentNode *get(PersistentNode *x, const string &key, size_t d) {
+        if (x == nullptr) return nullptr;
+        if (d == key.length()) return x;
+        unsigned char c = key[d];
+        return get(x->next[c], key, d + 1);
+    }
+
+    /**
+     * Służy do wstawienia słowa do nowej wersji drzewa
+     *
+     * @param x - węzeł poprzedniej wersji, może być null
+     * @param key - klucz
+     * @param value - wartość
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @return - kopia węzła x z wstawionym kluczem
+     *
+     * kopiujemy węzeł x
+     * jeśli doszliśmy do końca słowa przypisujemy wartość
+     * w przeciwnym wypadku dziecko odpowiadające kolejnej literze zastępujemy rekurencyjnie utworzoną kopią
+     */
+    static PersistentNode *insert(PersistentNode *x, const string &key, int value, size_t d) {
+        if (d == key.size()) {
+            PersistentNode *y = copy(x, -1);
+            y->value = value;
+            return y;
+        }
+        unsigned char c = key[d];
+        PersistentNode *y = copy(x, c);
+        y->next[c] = insert(x == nullptr ? nullptr : x->next[c], key, value, d + 1);
+        return y;
+    }
+
+    /**
+     * Służy do usunięcia klucza w nowej wersji drzewa, klucz musi znajdować się w drzewie
+     *
+     * @param x - węzeł poprzedniej wersji
+     * @param key - klucz
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @return - kopia węzła x bez klucza, lub null jeśli węzeł przestał być potrzebny
+     *
+     * jeśli doszliśmy do końca słowa
+     *  jeśli węzeł nie ma dzieci zwracamy null
+     *  w przeciwnym wypadku zwracamy kopię z wyzerowaną wartością
+     * usuwamy klucz z dziecka odpowiadającego kolejnej literze
+     * jeśli dziecko zniknęło, a węzeł nie przechowuje wartości i nie ma innych dzieci zwracamy null
+     * w przeciwnym wypadku zwracamy kopię z podmienionym dzieckiem
+     */
+    static PersistentNode *del(PersistentNode *x, const string &key, size_t d) {
+        if (d == key.size()) {
+            if (!hasChildren(x, -1)) return nullptr;
+            PersistentNode *y = copy(x, -1);
+            y->value = 0;
+            return y;
+        }
+        unsigned char c = key[d];
+        PersistentNode *child = del(x->next[c], key, d + 1);
+        if (child == nullptr && x->value == 0 && !hasChildren(x, c)) return nullptr;
+        PersistentNode *y = copy(x, c);
+        y->next[c] = child;
+        return y;
+    }
+
+    static bool hasChildren(PersistentNode *x, int skip) {
+        for (int c = 0; c < 256; c++)
+            if (c != skip && x->next[c] != nullptr)
+                return true;
+        return false;
+    }
+
+    static int longestPrefixOf(PersistentNode *x, const string &query, size_t d, int length) {
+        if (x == nullptr) return length;
+        if (x->value != 0) length = (int) d;
+        if (d == query.length()) return length;
+        unsigned char c = query[d];
+        return longestPrefixOf(x->next[c], query, d + 1, length);
+    }
+
+    static void collect(PersistentNode *x, string &key, vector<string> &queue) {
+        if (x == nullptr) return;
+        if (x->value != 0) queue.push_back(key);
+        for (int c = 0; c < 256; c++) {
+            if (x->next[c] == nullptr) continue;
+            key.push_back((char) c);
+            collect(x->next[c], key, queue);
+            key.pop_back();
+        }
+    }
+
+    static int size(PersistentNode *x) {
+        if (x == nullptr) return 0;
+        int counter = x->value != 0 ? 1 : 0;
+        for (int c = 0; c < 256; c++)
+            counter += size(x->next[c]);
+        return counter;
+    }
+
+public:
+    /**
+     * Konstruktor domyślny, tworzy pustą wersję drzewa
+     */
+    PersistentTRIETree() : root(nullptr) {}
+
+    PersistentTRIETree(const PersistentTRIETree &other) : root(retain(other.root)) {}
+
+    PersistentTRIETree(PersistentTRIETree &&other) noexcept : root(other.root) {
+        other.root = nullptr;
+    }
+
+    PersistentTRIETree &operator=(PersistentTRIETree other) {
+        swap(root, other.root);
+        return *this;
+    }
+
+    /**
+     * Destruktor, oddaje referencję do korzenia - węzły których nie używa żadna inna wersja są zwalniane
+     */
+    ~PersistentTRIETree() {
+        release(root);
+    }
+
+    /**
+     * Służy do wykonania migawki aktualnej wersji drzewa
+     *
+     * @return - wersja drzewa współdzieląca wszystkie węzły z aktualną, koszt O(1)
+     */
+    PersistentTRIETree snapshot() const {
+        return *this;
+    }
+
+    /**
+     * Służy do wstawienia słowa
+     *
+     * @param key - słowo które wstawiamy
+     * @param value - wartość przypisana danemu słowu
+     * @return - nowa wersja drzewa, kopiowane są tylko węzły na ścieżce klucza
+     */
+    PersistentTRIETree insert(const string &key, int value) const {
+        return PersistentTRIETree(insert(root, key, value, 0));
+    }
+
+    /**
+     * Służy do usunięcia klucza
+     *
+     * @param key - klucz
+     * @return - nowa wersja drzewa bez klucza, jeśli klucza nie ma w drzewie zwracamy migawkę aktualnej wersji
+     */
+    PersistentTRIETree del(const string &key) const {
+        PersistentNode *x = get(root, key, 0);
+        if (x == nullptr || x->value == 0) return snapshot();
+        return PersistentTRIETree(del(root, key, 0));
+    }
+
+    int get(const string &key) const {
+        PersistentNode *x = get(root, key, 0);
+        if (x == nullptr) return 0;
+        return x->value;
+    }
+
+    bool contains(const string &key) const {
+        return get(key) != 0;
+    }
+
+    string longestPrefixOf(const string &query) const {
+        return query.substr(0, longestPrefixOf(root, query, 0, 0));
+    }
+
+    vector<string> keys() const {
+        return keysWithPrefix("");
+    }
+
+    vector<string> keysWithPrefix(const string &prefix) const {
+        vector<string> queue;
+        string key = prefix;
+        collect(get(root, prefix, 0), key, queue);
+        return queue;
+    }
+
+    int size() const {
+        return size(root);
+    }
+
+    bool isEmpty() const {
+        return root == nullptr || size() == 0;
+    }
+};
+
+/**
+ * Węzeł drzewa TRIE z kompresją ogonów
+ *
+ * Jeśli tailLength > 0 węzeł jest liściem z ogonem: w jego poddrzewie jest dokładnie jeden klucz - ścieżka do węzła
+ * i tailLength bajtów ogona zapisanego we wspólnym buforze od pozycji tailOffset, a value jest wartością tego klucza.
+ */
+struct TailNode {
+    int value = 0;
+    uint32_t tailOffset = 0;
+    uint32_t tailLength = 0;
+    struct TailNode *next[256];
+};
+
+/**
+ * Drzewo TRIE z kompresją unikalnych końcówek kluczy (tail compression)
+ *
+ * Gdy poddrzewo zawiera tylko jeden klucz, zamiast łańcucha węzłów (po jednym na bajt) przechowujemy jeden węzeł,
+ * a pozostałe bajty klucza trafiają do wspólnego, upakowanego bufora ogonów. Wstawienie klucza rozchodzącego się
+ * z ogonem rozbija ogon po jednym poziomie - końcówka ogona jest fragmentem tego samego bufora, więc nie jest kopiowana.
+ * Usunięcie klucza zwija poddrzewo z jednym kluczem z powrotem do liścia z ogonem. Bufor jest przepakowywany,
+ * gdy nieużywane fragmenty zajmują ponad połowę jego rozmiaru.
+ */
+class TailTRIETree {
+private:
+    TailNode *root = nullptr;
+    string tails;
+    size_t garbage = 0;
+    size_t nodes = 0;
+
+    TailNode *newNode() {
+        nodes++;
+        return new TailNode();
+    }
+
+    void freeNode(TailNode *x) {
+        garbage += x->tailLength;
+        nodes--;
+        delete x;
+    }
+
+    /**
+     * Służy do utworzenia liścia przechowującego końcówkę klucza od pozycji d
+     *
+     * jeśli końcówka jest pusta tworzymy zwykły węzeł z wartością
+     * w przeciwnym wypadku dopisujemy końcówkę do bufora ogonów
+     */
+    TailNode *leaf(const string &key, size_t d, int value) {
+        TailNode *x = newNode();
+        x->value = value;
+        if (d < key.size()) {
+            x->tailOffset = tails.size();
+            x->tailLength = key.size() - d;
+            tails.append(key, d, string::npos);
+        }
+        return x;
+    }
+
+    bool tailEquals(TailNode *x, const string &key, size_t d) const {
+        return key.size() - d == x->tailLength && tails.compare(x->tailOffset, x->tailLength, key, d, x->tailLength) == 0;
+    }
+
+    /**
+     * Służy do wstawiania słowa do drzewa
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param key - klucz
+     * @param value - wartość
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @return - przetworzony węzeł
+     *
+     * jeśli węzeł nie istnieje tworzymy liść z ogonem zawierającym resztę klucza
+     * jeśli węzeł jest liściem z ogonem
+     *  jeśli reszta klucza jest równa ogonowi podmieniamy wartość
+     *  w przeciwnym wypadku rozbijamy liść: staje się zwykłym węzłem, a jego klucz przenosimy do dziecka
+     *  odpowiadającego pierwszemu bajtowi ogona (z ogonem krótszym o ten bajt, który staje się nieużywany)
+     * dalej wstawiamy jak w zwykłym drzewie TRIE
+     */
+    TailNode *insert(TailNode *x, const string &key, int value, size_t d) {
+        if (x == nullptr) return leaf(key, d, value);
+        if (x->tailLength > 0) {
+            if (tailEquals(x, key, d)) {
+                x->value = value;
+                return x;
+            }
+            TailNode *moved = newNode();
+            moved->value = x->value;
+            moved->tailOffset = x->tailOffset + 1;
+            moved->tailLength = x->tailLength - 1;
+            garbage++;
+            x->next[(unsigned char) tails[x->tailOffset]] = moved;
+            x->value = 0;
+            x->tailLength = 0;
+        }
+        if (d == key.size()) {
+            x->value = value;
+            return x;
+        }
+        unsigned char c = key[d];
+        x->next[c] = insert(x->next[c], key, value, d + 1);
+        return x;
+    }
+
+    /**
+     * Służy do zwinięcia poddrzewa z jednym kluczem do liścia z ogonem
+     *
+     * @param x - węzeł bez wartości, z którego prowadzi łańcuch węzłów z jednym dzieckiem zakończony liściem
+     *
+     * zbieramy bajty łańcucha i ogon liścia do osobnego łańcucha znaków, zwalniając kolejne węzły
+     * dopisujemy zebraną końcówkę do bufora ogonów jednym wywołaniem
+     */
+    void collapse(TailNode *x) {
+        string tail;
+        int value = 0;
+        TailNode *y = x;
+        for (;;) {
+            int only = -1;
+            if (y->tailLength == 0)
+                for (int c = 0; c < 256 && only == -1; c++)
+                    if (y->next[c] != nullptr) only = c;
+            if (only == -1) {
+                value = y->value;
+                tail.append(tails, y->tailOffset, y->tailLength);
+                break;
+            }
+            tail.push_back((char) only);
+            TailNode *child = y->next[only];
+            if (y == x) x->next[only] = nullptr;
+            else freeNode(y);
+            y = child;
+        }
+        if (y != x) freeNode(y);
+        x->value = value;
+        x->tailOffset = tails.size();
+        x->tailLength = tail.size();
+        tails.append(tail);
+    }
+
+    /**
+     * Służy do usuwania klucza z drzewa
+     *
+     * @param single - ustawiane na true, jeśli zwrócone poddrzewo zawiera dokładnie jeden klucz
+     * @return - przetworzony węzeł, lub null jeśli węzeł został zwolniony
+     *
+     * jeśli węzeł jest liściem z ogonem pasującym do reszty klucza zwalniamy go
+     * w przeciwnym wypadku usuwamy klucz jak w zwykłym drzewie TRIE, a następnie
+     *  jeśli węzeł nie przechowuje wartości i nie ma dzieci zwalniamy go
+     *  jeśli węzeł nie przechowuje wartości i ma jedno dziecko z jednym kluczem, zwinięcie zostawiamy przodkowi,
+     *   dzięki czemu łańcuch jest zwijany tylko raz, w najwyższym węźle który go zawiera
+     *  w przeciwnym wypadku zwijamy dziecko na ścieżce klucza, jeśli zawiera jeden klucz a nie jest jeszcze liściem
+     */
+    TailNode *del(TailNode *x, const string &key, size_t d, bool &single) {
+        single = false;
+        if (x == nullptr) return nullptr;
+        if (x->tailLength > 0) {
+            if (!tailEquals(x, key, d)) {
+                single = true;
+                return x;
+            }
+            freeNode(x);
+            return nullptr;
+        }
+        int path = -1;
+        bool pathSingle = false;
+        if (d == key.size()) x->value = 0;
+        else {
+            path = (unsigned char) key[d];
+            x->next[path] = del(x->next[path], key, d + 1, pathSingle);
+        }
+        int only = -1, children = 0;
+        for (int c = 0; c < 256; c++)
+            if (x->next[c] != nullptr) {
+                only = c;
+                children++;
+            }
+        if (x->value == 0 && children == 0) {
+            freeNode(x);
+            return nullptr;
+        }
+        if (x->value == 0 && children == 1) {
+            single = only == path ? pathSingle : isLeaf(x->next[only]);
+            if (single) return x;
+        }
+        if (x->value != 0 && children == 0) single = true;
+        if (path != -1 && pathSingle && x->next[path] != nullptr && !isLeaf(x->next[path])) collapse(x->next[path]);
+        return x;
+    }
+
+    bool isLeaf(TailNode *x) const {
+        if (x->tailLength > 0) return true;
+        for (int c = 0; c < 256; c++)
+            if (x->next[c] != nullptr)
+                return false;
+        return true;
+    }
+
+    /**
+     * Służy do przepakowania bufora ogonów, pomija fragmenty nieużywane przez żaden węzeł
+     */
+    void repack() {
+        string packed;
+        packed.reserve(tails.size() - garbage);
+        vector<TailNode *> stack;
+        if (root != nullptr) stack.push_back(root);
+        while (!stack.empty()) {
+            TailNode *x = stack.back();
+            stack.pop_back();
+            if (x->tailLength > 0) {
+                uint32_t offset = packed.size();
+                packed.append(tails, x->tailOffset, x->tailLength);
+                x->tailOffset = offset;
+            }
+            for (int c = 0; c < 256; c++)
+                if (x->next[c] != nullptr)
+                    stack.push_back(x->next[c]);
+        }
+        tails.swap(packed);
+        garbage = 0;
+    }
+
+    void collect(TailNode *x, string &key, vector<string> &queue) const {
+        if (x == nullptr) return;
+        if (x->tailLength > 0) {
+            queue.push_back(key + tails.substr(x->tailOffset, x->tailLength));
+            return;
+        }
+        if (x->value != 0) queue.push_back(key);
+        for (int c = 0; c < 256; c++) {
+            if (x->next[c] == nullptr) continue;
+            key.push_back((char) c);
+            collect(x->next[c], key, queue);
+            key.pop_back();
+        }
+    }
+
+    void collect(TailNode *x, string &prefix, const string &pat, vector<string> &q) const {
+        if (x == nullptr) return;
+        if (x->tailLength > 0) {
+            if (pat.size() - prefix.size() != x->tailLength) return;
+            for (size_t i = 0; i < x->tailLength; i++)
+                if (pat[prefix.size() + i] != '.' && pat[prefix.size() + i] != tails[x->tailOffset + i])
+                    return;
+            q.push_back(prefix + tails.substr(x->tailOffset, x->tailLength));
+            return;
+        }
+        if (prefix.length() == pat.length()) {
+            if (x->value != 0) q.push_back(prefix);
+            return;
+        }
+        unsigned char next = pat[prefix.length()];
+        for (int c = 0; c < 256; c++) {
+            if (next != '.' && next != c) continue;
+            prefix.push_back((char) c);
+            collect(x->next[c], prefix, pat, q);
+            prefix.pop_back();
+        }
+    }
+
+    int size(TailNode *x) const {
+        if (x == nullptr) return 0;
+        int counter = x->value != 0 ? 1 : 0;
+        for (int c = 0; c < 256; c++)
+            counter += size(x->next[c]);
+        return counter;
+    }
+
+    void destroy(TailNode *x) {
+        if (x == nullptr) return;
+        for (int c = 0; c < 256; c++)
+            destroy(x->next[c]);
+        delete x;
+    }
+
+public:
+    TailTRIETree() = default;
+    TailTRIETree(const TailTRIETree &) = delete;
+    TailTRIETree &operator=(const TailTRIETree &) = delete;
+
+    ~TailTRIETree() {
+        destroy(root);
+    }
+
+    /**
+     * Służy do zwracania wartości powiązanej z kluczem
+     *
+     * schodzimy po kolejnych literach klucza
+     * jeśli trafimy na liść z ogonem porównujemy resztę klucza z ogonem
+     */
+    int get(const string &key) const {
+        TailNode *x = root;
+        for (size_t d = 0; x != nullptr; d++) {
+            if (x->tailLength > 0) return tailEquals(x, key, d) ? x->value : 0;
+            if (d == key.size()) return x->value;
+            x = x->next[(unsigned char) key[d]];
+        }
+        return 0;
+    }
+
+    bool contains(const string &key) const {
+        return get(key) != 0;
+    }
+
+    void insert(const string &key, int value) {
+        if (value == 0) {
+            del(key);
+            return;
+        }
+        root = insert(root, key, value, 0);
+    }
+
+    void del(const string &key) {
+        bool single;
+        root = del(root, key, 0, single);
+        if (single && !isLeaf(root)) collapse(root);
+        if (garbage > 4096 && garbage * 2 > tails.size()) repack();
+    }
+
+    /**
+     * Służy do wyszukiwania najdłuższego przedrostka danego słowa
+     *
+     * jeśli trafimy na liść z ogonem, jego klucz jest przedrostkiem zapytania gdy ogon jest przedrostkiem reszty zapytania
+     */
+    string longestPrefixOf(const string &query) const {
+        size_t length = 0;
+        TailNode *x = root;
+        for (size_t d = 0; x != nullptr; d++) {
+            if (x->tailLength > 0) {
+                if (query.size() - d >= x->tailLength &&
+                    tails.compare(x->tailOffset, x->tailLength, query, d, x->tailLength) == 0)
+                    length = d + x->tailLength;
+                break;
+            }
+            if (x->value != 0) length = d;
+            if (d == query.size()) break;
+            x = x->next[(unsigned char) query[d]];
+        }
+        return query.substr(0, length);
+    }
+
+    vector<string> keys() const {
+        return keysWithPrefix("");
+    }
+
+    /**
+     * Służy do zebrania kluczy z danym przedrostkiem
+     *
+     * jeśli przedrostek kończy się wewnątrz ogona, jedynym kandydatem jest klucz tego liścia
+     */
+    vector<string> keysWithPrefix(const string &prefix) const {
+        vector<string> queue;
+        TailNode *x = root;
+        size_t d = 0;
+        for (; x != nullptr && x->tailLength == 0 && d < prefix.size(); d++)
+            x = x->next[(unsigned char) prefix[d]];
+        if (x == nullptr) return queue;
+        string key = prefix.substr(0, d);
+        if (x->tailLength > 0) {
+            string full = key + tails.substr(x->tailOffset, x->tailLength);
+            if (full.compare(0, prefix.size(), prefix) == 0) queue.push_back(full);
+            return queue;
+        }
+        collect(x, key, queue);
+        return queue;
+    }
+
+    vector<string> keysThatMatch(const string &pat) const {
+        vector<string> q;
+        string prefix;
+        collect(root, prefix, pat, q);
+        return q;
+    }
+
+    int size() const {
+        return size(root);
+    }
+
+    bool isEmpty() const {
+        return root == nullptr;
+    }
+
+    /**
+     * Służy do oszacowania pamięci zajmowanej przez drzewo
+     *
+     * @return - rozmiar węzłów i bufora ogonów w bajtach
+     */
+    size_t memoryUsage() const {
+        return nodes * sizeof(TailNode) + tails.capacity();
+    }
+};
+
+/**
+ * Węzeł drzewa BurstTRIETree - zwykły węzeł drzewa TRIE (BurstTrieNode) albo kontener końcówek kluczy (BurstContainer)
+ */
+struct BurstNode {
+    bool container;
+};
+
+struct BurstTrieNode : BurstNode {
+    int value = 0;
+    struct BurstNode *next[256];
+
+    BurstTrieNode() : BurstNode{false}, next() {}
+};
+
+/**
+ * Kontener końcówek kluczy - posortowana tablica rekordów (długość końcówki, wartość, bajty końcówki)
+ * upakowanych jeden za drugim w jednym buforze, dzięki czemu przeszukiwanie kontenera czyta pamięć sekwencyjnie
+ */
+struct BurstContainer : BurstNode {
+    string data;
+    int count = 0;
+
+    BurstContainer() : BurstNode{true} {}
+};
+
+/**
+ * Drzewo TRIE z kontenerami na liściach (burst trie, podobnie jak HAT-trie)
+ *
+ * Poddrzewa zawierające najwyżej BURST_THRESHOLD kluczy nie są rozwijane w węzły - końcówki ich kluczy leżą
+ * w jednym kontenerze pod węzłem rodzica. Gdy kontener przekroczy próg, jest rozbijany (burst) na węzeł drzewa TRIE
+ * i kontenery dla kolejnych bajtów. Rzadkie, głębokie końcówki kluczy nie zajmują więc po jednym węźle na bajt.
+ */
+class BurstTRIETree {
+private:
+    /**
+     * Ilość kluczy w kontenerze po przekroczeniu której kontener jest rozbijany
+     */
+    static const int BURST_THRESHOLD = 64;
+
+    /**
+     * Rekord kontenera: pozycja bajtów końcówki w buforze, długość końcówki i wartość
+     */
+    struct Entry {
+        size_t offset;
+        uint32_t length;
+        int value;
+    };
+
+    BurstNode *root = nullptr;
+
+    static BurstTrieNode *trie(BurstNode *x) {
+        return static_cast<BurstTrieNode *>(x);
+    }
+
+    static BurstContainer *bucket(BurstNode *x) {
+        return static_cast<BurstContainer *>(x);
+    }
+
+    static Entry entry(const BurstContainer *b, size_t position) {
+        Entry e;
+        memcpy(&e.length, &b->data[position], sizeof(e.length));
+        memcpy(&e.value, &b->data[position + sizeof(e.length)], sizeof(e.value));
+        e.offset = position + sizeof(e.length) + sizeof(e.value);
+        return e;
+    }
+
+    static void append(BurstContainer *b, const char *suffix, uint32_t length, int value) {
+        b->data.append((const char *) &length, sizeof(length));
+        b->data.append((const char *) &value, sizeof(value));
+        b->data.append(suffix, length);
+        b->count++;
+    }
+
+    /**
+     * Służy do znalezienia w kontenerze pierwszego rekordu, którego końcówka nie jest mniejsza od końcówki klucza od pozycji d
+     *
+     * @param position - pozycja znalezionego rekordu lub rozmiar bufora
+     * @return - true jeśli końcówka rekordu jest równa końcówce klucza
+     */
+    static bool find(const BurstContainer *b, const string &key, size_t d, size_t &position) {
+        for (position = 0; position < b->data.size();) {
+            Entry e = entry(b, position);
+            int compared = b->data.compare(e.offset, e.length, key, d, string::npos);
+            if (compared == 0) return true;
+            if (compared > 0) return false;
+            position = e.offset + e.length;
+        }
+        return false;
+    }
+
+    /**
+     * Służy do rozbicia kontenera na węzeł drzewa TRIE
+     *
+     * @param b - kontener, zostaje zwolniony
+     * @return - nowy węzeł
+     *
+     * rekord z pustą końcówką staje się wartością węzła
+     * pozostałe rekordy dopisujemy (w dalszym ciągu posortowane) do kontenerów dzieci odpowiadających pierwszemu bajtowi końcówki,
+     * skracając końcówkę o ten bajt
+     * kontenery dzieci które nadal przekraczają próg rozbijamy rekurencyjnie
+     */
+    BurstNode *burst(BurstContainer *b) {
+        BurstTrieNode *x = new BurstTrieNode();
+        for (size_t position = 0; position < b->data.size();) {
+            Entry e = entry(b, position);
+            position = e.offset + e.length;
+            if (e.length == 0) {
+                x->value = e.value;
+                continue;
+            }
+            unsigned char c = b->data[e.offset];
+            if (x->next[c] == nullptr) x->next[c] = new BurstContainer();
+            append(bucket(x->next[c]), &b->data[e.offset + 1], e.length - 1, e.value);
+        }
+        delete b;
+        for (int c = 0; c < 256; c++)
+            if (x->next[c] != nullptr && bucket(x->next[c])->count > BURST_THRESHOLD)
+                x->next[c] = burst(bucket(x->next[c]));
+        return x;
+    }
+
+    /**
+     * Służy do wstawiania słowa do drzewa
+     *
+     * @param x - węzeł który aktualnie przetwarzamy
+     * @param key - klucz
+     * @param value - wartość
+     * @param d - indeks aktualnie przetwarzanej litery w słowie
+     * @return - przetworzony węzeł
+     *
+     * jeśli węzeł nie istnieje tworzymy pusty kontener
+     * jeśli węzeł jest kontenerem
+     *  jeśli końcówka klucza jest w kontenerze podmieniamy wartość
+     *  w przeciwnym wypadku wstawiamy rekord w miejsce zachowujące porządek i rozbijamy kontener jeśli przekroczył próg
+     * dalej wstawiamy jak w zwykłym drzewie TRIE
+     */
+    BurstNode *insert(BurstNode *x, const string &key, int value, size_t d) {
+        if (x == nullptr) x = new BurstContainer();
+        if (x->container) {
+            BurstContainer *b = bucket(x);
+            size_t position;
+            if (find(b, key, d, position)) {
+                memcpy(&b->data[position + sizeof(uint32_t)], &value, sizeof(value));
+                return x;
+            }
+            BurstContainer record;
+            append(&record, key.data() + d, key.size() - d, value);
+            b->data.insert(position, record.data);
+            b->count++;
+            return b->count > BURST_THRESHOLD ? burst(b) : x;
+        }
+        BurstTrieNode *t = trie(x);
+        if (d == key.size()) t->value = value;
+        else {
+            unsigned char c = key[d];
+            t->next[c] = insert(t->next[c], key, value, d + 1);
+        }
+        return x;
+    }
+
+    /**
+     * Służy do usuwania klucza z drzewa
+     *
+     * @return - przetworzony węzeł, lub null jeśli węzeł został zwolniony
+     *
+     * jeśli węzeł jest kontenerem usuwamy z niego rekord, a pusty kontener zwalniamy
+     * w przeciwnym wypadku usuwamy klucz jak w zwykłym drzewie TRIE,
+     *  a jeśli węzeł nie przechowuje wartości i nie ma dzieci zwalniamy go
+     */
+    BurstNode *del(BurstNode *x, const string &key, size_t d) {
+        if (x == nullptr) return nullptr;
+        if (x->container) {
+            BurstContainer *b = bucket(x);
+            size_t position;
+            if (!find(b, key, d, position)) return x;
+            Entry e = entry(b, position);
+            b->data.erase(position, e.offset + e.length - position);
+            if (--b->count > 0) return x;
+            delete b;
+            return nullptr;
+        }
+        BurstTrieNode *t = trie(x);
+        if (d == key.size()) t->value = 0;
+        else {
+            unsigned char c = key[d];
+            t->next[c] = del(t->next[c], key, d + 1);
+        }
+        if (t->value != 0) return x;
+        for (int c = 0; c < 256; c++)
+            if (t->next[c] != nullptr)
+                return x;
+        delete t;
+        return nullptr;
+    }
+
+    /**
+     * Służy do zebrania kluczy poddrzewa zaczynających się od przedrostka
+     *
+     * @param key - ścieżka do węzła x
+     * @param prefix - przedrostek, część od pozycji key.size() jest dopasowywana do końcówek w kontenerach
+     */
+    void collectWithPrefix(BurstNode *x, string &key, const string &prefix, vector<string> &queue) const {
+        if (x == nullptr) return;
+        if (x->container) {
+            BurstContainer *b = bucket(x);
+            size_t d = key.size();
+            for (size_t position = 0; position < b->data.size();) {
+                Entry e = entry(b, position);
+                position = e.offset + e.length;
+                size_t rest = prefix.size() > d ? prefix.size() - d : 0;
+                if (rest == 0 || (e.length >= rest && b->data.compare(e.offset, rest, prefix, d, rest) == 0))
+                    queue.push_back(key + b->data.substr(e.offset, e.length));
+            }
+            return;
+        }
+        BurstTrieNode *t = trie(x);
+        if (key.size() >= prefix.size() && t->value != 0) queue.push_back(key);
+        for (int c = 0; c < 256; c++) {
+            if (t->next[c] == nullptr) continue;
+            if (key.size() < prefix.size() && (unsigned char) prefix[key.size()] != c) continue;
+            key.push_back((char) c);
+            collectWithPrefix(t->next[c], key, prefix, queue);
+            key.pop_back();
+        }
+    }
+
+    void collect(BurstNode *x, string &prefix, const string &pat, vector<string> &q) const {
+        if (x == nullptr) return;
+        if (x->container) {
+            BurstContainer *b = bucket(x);
+            size_t d = prefix.size();
+            for (size_t position = 0; position < b->data.size();) {
+                Entry e = entry(b, position);
+                position = e.offset + e.length;
+                if (pat.size() - d != e.length) continue;
+                bool matches = true;
+                for (size_t i = 0; matches && i < e.length; i++)
+                    matches = pat[d + i] == '.' || pat[d + i] == b->data[e.offset + i];
+                if (matches) q.push_back(prefix + b->data.substr(e.offset, e.length));
+            }
+            return;
+        }
+        BurstTrieNode *t = trie(x);
+        if (prefix.length() == pat.length()) {
+            if (t->value != 0) q.push_back(prefix);
+            return;
+        }
+        unsigned char next = pat[prefix.length()];
+        for (int c = 0; c < 256; c++) {
+            if (next != '.' && next != c) continue;
+            prefix.push_back((char) c);
+            collect(t->next[c], prefix, pat, q);
+            prefix.pop_back();
+        }
+    }
+
+    int size(BurstNode *x) const {
+        if (x == nullptr) return 0;
+        if (x->container) return bucket(x)->count;
+        int counter = trie(x)->value != 0 ? 1 : 0;
+        for (int c = 0; c < 256; c++)
+            counter += size(trie(x)->next[c]);
+        return counter;
+    }
+
+    size_t memoryUsage(BurstNode *x) const {
+        if (x == nullptr) return 0;
+        if (x->container) return sizeof(BurstContainer) + bucket(x)->data.capacity();
+        size_t bytes = sizeof(BurstTrieNode);
+        for (int c = 0; c < 256; c++)
+            bytes += memoryUsage(trie(x)->next[c]);
+        return bytes;
+    }
+
+    void destroy(BurstNode *x) {
+        if (x == nullptr) return;
+        if (x->container) {
+            delete bucket(x);
+            return;
+        }
+        for (int c = 0; c < 256; c++)
+            destroy(trie(x)->next[c]);
+        delete trie(x);
+    }
+
+public:
+    BurstTRIETree() = default;
+    BurstTRIETree(const BurstTRIETree &) = delete;
+    BurstTRIETree &operator=(const BurstTRIETree &) = delete;
+
+    ~BurstTRIETree() {
+        destroy(root);
+    }
+
+    /**
+     * Służy do zwracania wartości powiązanej z kluczem
+     *
+     * schodzimy po kolejnych literach klucza
+     * jeśli trafimy na kontener szukamy w nim reszty klucza
+     */
+    int get(const string &key) const {
+        BurstNode *x = root;
+        for (size_t d = 0; x != nullptr; d++) {
+            if (x->container) {
+                size_t position;
+                if (!find(bucket(x), key, d, position)) return 0;
+                return entry(bucket(x), position).value;
+            }
+            if (d == key.size()) return trie(x)->value;
+            x = trie(x)->next[(unsigned char) key[d]];
+        }
+        return 0;
+    }
+
+    bool contains(const string &key) const {
+        return get(key) != 0;
+    }
+
+    void insert(const string &key, int value) {
+        if (value == 0) {
+            del(key);
+            return;
+        }
+        root = insert(root, key, value, 0);
+    }
+
+    void del(const string &key) {
+        root = del(root, key, 0);
+    }
+
+    /**
+     * Służy do wyszukiwania najdłuższego przedrostka danego słowa
+     *
+     * jeśli trafimy na kontener, sprawdzamy które końcówki w nim są przedrostkami reszty zapytania i wybieramy najdłuższą
+     */
+    string longestPrefixOf(const string &query) const {
+        size_t length = 0;
+        BurstNode *x = root;
+        for (size_t d = 0; x != nullptr; d++) {
+            if (x->container) {
+                BurstContainer *b = bucket(x);
+                for (size_t position = 0; position < b->data.size();) {
+                    Entry e = entry(b, position);
+                    position = e.offset + e.length;
+                    if (query.size() - d >= e.length && b->data.compare(e.offset, e.length, query, d, e.length) == 0)
+                        length = max(length, d + e.length);
+                }
+                break;
+            }
+            if (trie(x)->value != 0) length = d;
+            if (d == query.size()) break;
+            x = trie(x)->next[(unsigned char) query[d]];
+        }
+        return query.substr(0, length);
+    }
+
+    vector<string> keys() const {
+        return keysWithPrefix("");
+    }
+
+    vector<string> keysWithPrefix(const string &prefix) const {
+        vector<string> queue;
+        string key;
+        collectWithPrefix(root, key, prefix, queue);
+        return queue;
+    }
+
+    vector<string> keysThatMatch(const string &pat) const {
+        vector<string> q;
+        string prefix;
+        collect(root, prefix, pat, q);
+        return q;
+    }
+
+    int size() const {
+        return size(root);
+    }
+
+    bool isEmpty() const {
+        return root == nullptr;
+    }
+
+    /**
+     * Służy do oszacowania pamięci zajmowanej przez drzewo
+     *
+     * @return - rozmiar węzłów i kontenerów w bajtach
+     */
+    size_t memoryUsage() const {
+        return memoryUsage(root);
+    }
+};
+
+/**
+ * Liczniki TRIECache: trafienia i chybienia metod get i longestPrefixOf oraz ilość usuniętych kluczy
+ */
+struct TRIECacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+/**
+ * Pamięć podręczna oparta na drzewie TRIE z ograniczoną ilością kluczy i usuwaniem metodą CLOCK
+ *
+ * Klucze są przechowywane w TRIETree, a wartością klucza w drzewie jest numer jego miejsca w tablicy slots,
+ * która przechowuje prawdziwą wartość i bit odwołania. Odczyt ustawia bit odwołania jednym zapisem, bez przestawiania list
+ * jak w LRU. Wstawienie nowego klucza do pełnej pamięci przesuwa wskazówkę zegara po tablicy: klucze z ustawionym
+ * bitem dostają drugą szansę (bit jest czyszczony), a pierwszy klucz bez bitu jest usuwany z drzewa razem
+ * z węzłami, które przestały być potrzebne.
+ */
+class TRIECache {
+private:
+    struct CacheSlot {
+        string key;
+        int value = 0;
+        bool referenced = false;
+    };
+
+    TRIETree tree;
+    vector<CacheSlot> slots;
+    vector<size_t> freeSlots;
+    size_t capacity;
+    size_t hand = 0;
+    TRIECacheStats stats;
+
+    /**
+     * Służy do usunięcia jednego zimnego klucza
+     *
+     * przesuwamy wskazówkę po tablicy pomijając puste miejsca
+     * jeśli klucz ma ustawiony bit odwołania czyścimy go, w przeciwnym wypadku usuwamy klucz i zwalniamy jego miejsce
+     */
+    void evict() {
+        for (;;) {
+            CacheSlot &slot = slots[hand];
+            size_t index = hand;
+            hand = (hand + 1) % slots.size();
+            if (slot.value == 0) continue;
+            if (slot.referenced) {
+                slot.referenced = false;
+                continue;
+            }
+            tree.del(slot.key);
+            slot = CacheSlot();
+            freeSlots.push_back(index);
+            stats.evictions++;
+            return;
+        }
+    }
+
+public:
+    /**
+     * @param capacity - największa ilość kluczy w pamięci, co najmniej 1
+     */
+    explicit TRIECache(size_t capacity) : capacity(max(capacity, (size_t) 1)) {}
+
+    /**
+     * Służy do zwracania wartości powiązanej z kluczem i zaznaczenia odwołania do klucza
+     */
+    int get(const string &key) {
+        int slot = tree.get(key);
+        if (slot == 0) {
+            stats.misses++;
+            return 0;
+        }
+        stats.hits++;
+        slots[slot - 1].referenced = true;
+        return slots[slot - 1].value;
+    }
+
+    bool contains(const string &key) {
+        return get(key) != 0;
+    }
+
+    /**
+     * Służy do wstawienia klucza, jeśli pamięć jest pełna najpierw usuwamy zimny klucz
+     *
+     * @param key - klucz
+     * @param value - wartość, 0 usuwa klucz
+     */
+    void insert(const string &key, int value) {
+        if (value == 0) {
+            del(key);
+            return;
+        }
+        int slot = tree.get(key);
+        if (slot != 0) {
+            slots[slot - 1].value = value;
+            slots[slot - 1].referenced = true;
+            return;
+        }
+        if (size() >= capacity) evict();
+        size_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = slots.size();
+            slots.emplace_back();
+        }
+        slots[index].key = key;
+        slots[index].value = value;
+        slots[index].referenced = true;
+        tree.insert(key, index + 1);
+    }
+
+    void del(const string &key) {
+        int slot = tree.get(key);
+        if (slot == 0) return;
+        tree.del(key);
+        slots[slot - 1] = CacheSlot();
+        freeSlots.push_back(slot - 1);
+    }
+
+    /**
+     * Służy do wyszukania najdłuższego klucza będącego przedrostkiem zapytania (np. trasy dla adresu)
+     * i zaznaczenia odwołania do niego
+     *
+     * numer miejsca bierzemy z węzła znalezionego podczas jednego przejścia drzewa
+     */
+    string longestPrefixOf(const string &query) {
+        int slot;
+        string prefix = tree.longestPrefixOf(query, &slot);
+        if (slot == 0) {
+            stats.misses++;
+            return prefix;
+        }
+        stats.hits++;
+        slots[slot - 1].referenced = true;
+        return prefix;
+    }
+
+    vector<string> keysWithPrefix(const string &prefix) {
+        return tree.keysWithPrefix(prefix);
+    }
+
+    size_t size() const {
+        return slots.size() - freeSlots.size();
+    }
+
+    TRIECacheStats statistics() const {
+        return stats;
+    }
+};
+
+/**
+ * Polityka wywoływania fsync na dzienniku DurableTRIETree
+ *
+ * FSYNC_NEVER - dane trafiają do pamięci podręcznej systemu, o zapisie na dysk decyduje system operacyjny
+ * FSYNC_ON_COMMIT - fsync po zapisaniu każdej grupy operacji (group commit), operacje czekają na fsync swojej grupy
+ * FSYNC_ALWAYS - każda operacja jest zapisywana i synchronizowana osobno
+ */
+enum FsyncPolicy {
+    FSYNC_NEVER,
+    FSYNC_ON_COMMIT,
+    FSYNC_ALWAYS
+};
+
+/**
+ * Drzewo TRIE z dziennikiem zapisu z wyprzedzeniem (write-ahead log) i odtwarzaniem po awarii
+ *
+ * Każde insert i del jest dopisywane do dziennika <path>.wal i dopiero po zapisaniu (oraz fsync, zależnie od polityki)
+ * stosowane do drzewa, a wywołanie wraca gdy operacja jest już w dzienniku. Operacje wielu wątków są łączone w grupy
+ * (group commit): pierwszy czekający wątek zapisuje jednym wywołaniem write i fsync wszystkie oczekujące operacje
+ * (najwyżej batchSize), a wątki które dopisały swoje operacje w trakcie zapisu czekają na następną grupę.
+ * Co checkpointInterval operacji stan drzewa jest zapisywany do migawki <path>.snapshot, a dziennik jest czyszczony.
+ * Konstruktor odtwarza stan wczytując migawkę i powtarzając operacje z dziennika; niedokończony ostatni rekord
+ * (np. przerwany awarią) jest odrzucany. Operacje w dzienniku ustawiają lub usuwają klucz, więc ich ponowne
+ * zastosowanie na nowszej migawce (awaria między zapisem migawki a wyczyszczeniem dziennika) daje ten sam stan.
+ */
+class DurableTRIETree {
+private:
+    static const char OP_INSERT = 'I';
+    static const char OP_DEL = 'D';
+    static const size_t HEADER_SIZE = 13;
+
+    TRIETree tree;
+    string logPath;
+    string checkpointPath;
+    FsyncPolicy policy;
+    int batchSize;
+    int checkpointInterval;
+    struct Operation {
+        char op;
+        string key;
+        int value;
+    };
+
+    int logFd = -1;
+    string pending;
+    deque<Operation> operations;
+    uint64_t appended = 0;
+    uint64_t applied = 0;
+    bool writing = false;
+    condition_variable written;
+    int sinceCheckpoint = 0;
+    mutex lock;
+
+    /**
+     * Służy do wyliczenia sumy kontrolnej rekordu dziennika (FNV-1a)
+     */
+    static uint32_t checksum(const char *data, size_t length, uint32_t hash = 2166136261u) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char) data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static void writeAll(int fd, const char *data, size_t length) {
+        while (length > 0) {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw runtime_error("DurableTRIETree: write failed");
+            }
+            data += written;
+            length -= written;
+        }
+    }
+
+    static void syncPath(const string &path, int flags) {
+        int fd = ::open(path.c_str(), flags);
+        if (fd < 0) throw runtime_error("DurableTRIETree: cannot open " + path);
+        int synced = ::fsync(fd);
+        ::close(fd);
+        if (synced != 0) throw runtime_error("DurableTRIETree: fsync failed on " + path);
+    }
+
+    /**
+     * Służy do dopisania operacji do kolejki oczekującej na zapis
+     *
+     * @param op - rodzaj operacji
+     * @param key - klucz
+     * @param value - wartość
+     * @return - numer kolejny operacji
+     *
+     * rekord: rodzaj operacji (1 bajt), długość klucza (4 bajty), wartość (4 bajty), suma kontrolna (4 bajty), klucz
+     */
+    uint64_t append(char op, const string &key, int value) {
+        char header[HEADER_SIZE];
+        uint32_t length = key.size();
+        int32_t stored = value;
+        header[0] = op;
+        memcpy(header + 1, &length, sizeof(length));
+        memcpy(header + 5, &stored, sizeof(stored));
+        uint32_t sum = checksum(key.data(), key.size(), checksum(header, 9));
+        memcpy(header + 9, &sum, sizeof(sum));
+        pending.append(header, HEADER_SIZE);
+        pending.append(key);
+        operations.push_back({op, key, value});
+        return ++appended;
+    }
+
+    /**
+     * Służy do zapisania grupy rekordów na końcu dziennika
+     *
+     * zapamiętujemy koniec dziennika i zapisujemy grupę (oraz wywołujemy fsync, zależnie od polityki)
+     * jeśli zapis lub fsync się nie powiedzie obcinamy dziennik do zapamiętanego końca i rzucamy wyjątek
+     */
+    void writeLog(const string &group) {
+        off_t end = ::lseek(logFd, 0, SEEK_END);
+        if (end < 0) throw runtime_error("DurableTRIETree: cannot seek " + logPath);
+        try {
+            writeAll(logFd, group.data(), group.size());
+            if (policy != FSYNC_NEVER && ::fsync(logFd) != 0)
+                throw runtime_error("DurableTRIETree: fsync failed on " + logPath);
+        } catch (const exception &) {
+            if (::ftruncate(logFd, end) != 0) {
+                // nie da się już przywrócić dziennika, wyjątek i tak zgłasza niepotwierdzoną grupę
+            }
+            throw;
+        }
+    }
+
+    /**
+     * Służy do zapisania jednej grupy oczekujących operacji i zastosowania jej do drzewa, wywołujący trzyma blokadę
+     *
+     * bierzemy z początku kolejki najwyżej batchSize operacji (jedną przy FSYNC_ALWAYS)
+     * zapisujemy je do dziennika bez blokady, aby inne wątki mogły w tym czasie dopisywać kolejne operacje
+     * jeśli zapis się nie powiedzie operacje zostają w kolejce, nie są stosowane ani potwierdzane, a wyjątek przekazujemy dalej
+     * w przeciwnym wypadku usuwamy je z kolejki i stosujemy do drzewa w kolejności dziennika
+     * budzimy wątki czekające na swoje operacje
+     */
+    void writeGroup(unique_lock<mutex> &guard) {
+        size_t count = policy == FSYNC_ALWAYS ? 1 : min(operations.size(), (size_t) max(batchSize, 1));
+        size_t bytes = 0;
+        for (size_t i = 0; i < count; i++) bytes += HEADER_SIZE + operations[i].key.size();
+        string group = pending.substr(0, bytes);
+        writing = true;
+        guard.unlock();
+        try {
+            writeLog(group);
+        } catch (const exception &) {
+            guard.lock();
+            writing = false;
+            written.notify_all();
+            throw;
+        }
+        guard.lock();
+        pending.erase(0, bytes);
+        for (size_t i = 0; i < count; i++) {
+            Operation &operation = operations.front();
+            if (operation.op == OP_INSERT) tree.insert(operation.key, operation.value);
+            else tree.del(operation.key);
+            operations.pop_front();
+        }
+        applied += count;
+        sinceCheckpoint += count;
+        writing = false;
+        written.notify_all();
+    }
+
+    /**
+     * Służy do zaczekania aż operacja o danym numerze zostanie zapisana i zastosowana, wywołujący trzyma blokadę
+     *
+     * jeśli inny wątek zapisuje właśnie grupę czekamy na jej koniec
+     * w przeciwnym wypadku sami zapisujemy następną grupę
+     */
+    void await(unique_lock<mutex> &guard, uint64_t sequence) {
+        while (applied < sequence) {
+            if (writing) written.wait(guard);
+            else writeGroup(guard);
+        }
+    }
+
+    /**
+     * Służy do dopisania operacji i zaczekania na jej zapis, następnie w razie potrzeby wykonujemy migawkę
+     */
+    void log(char op, const string &key, int value) {
+        unique_lock<mutex> guard(lock);
+        await(guard, append(op, key, value));
+        if (checkpointInterval > 0 && sinceCheckpoint >= checkpointInterval) checkpointLocked(guard);
+    }
+
+    /**
+     * Służy do zapisania migawki i wyczyszczenia dziennika, wywołujący trzyma blokadę
+     *
+     * zapisujemy i stosujemy wszystkie oczekujące operacje
+     * zapisujemy migawkę do pliku tymczasowego, synchronizujemy go i atomowo podmieniamy przez rename
+     * synchronizujemy katalog aby rename przetrwał awarię
+     * czyścimy dziennik
+     */
+    void checkpointLocked(unique_lock<mutex> &guard) {
+        await(guard, appended);
+        string tmp = checkpointPath + ".tmp";
+        {
+            ofstream out(tmp, ios::binary | ios::trunc);
+            tree.save(out);
+            out.flush();
+            if (!out) throw runtime_error("DurableTRIETree: cannot write " + tmp);
+        }
+        syncPath(tmp, O_RDONLY);
+        if (rename(tmp.c_str(), checkpointPath.c_str()) != 0)
+            throw runtime_error("DurableTRIETree: cannot rename " + tmp);
+        size_t slash = checkpointPath.find_last_of('/');
+        syncPath(slash == string::npos ? "." : checkpointPath.substr(0, slash + 1), O_RDONLY | O_DIRECTORY);
+        if (::ftruncate(logFd, 0) != 0) throw runtime_error("DurableTRIETree: cannot truncate " + logPath);
+        if (::fsync(logFd) != 0) throw runtime_error("DurableTRIETree: fsync failed on " + logPath);
+        sinceCheckpoint = 0;
+    }
+
+    /**
+     * Służy do odtworzenia stanu drzewa po uruchomieniu
+     *
+     * jeśli istnieje migawka wczytujemy ją
+     * czytamy kolejne rekordy dziennika i stosujemy je do drzewa,
+     *  zatrzymując się na pierwszym niekompletnym lub uszkodzonym rekordzie
+     * obcinamy dziennik do ostatniego poprawnego rekordu i otwieramy go do dopisywania
+     */
+    void recover() {
+        ifstream snapshot(checkpointPath, ios::binary);
+        if (snapshot && !tree.load(snapshot))
+            throw runtime_error("DurableTRIETree: corrupted checkpoint " + checkpointPath);
+
+        off_t valid = 0;
+        ifstream log(logPath, ios::binary | ios::ate);
+        if (log) {
+            off_t end = log.tellg();
+            log.seekg(0);
+            char header[HEADER_SIZE];
+            while (log.read(header, HEADER_SIZE)) {
+                uint32_t length, sum;
+                int32_t value;
+                memcpy(&length, header + 1, sizeof(length));
+                memcpy(&value, header + 5, sizeof(value));
+                memcpy(&sum, header + 9, sizeof(sum));
+                if (length > end - valid - (off_t) HEADER_SIZE) break;
+                string key(length, '\0');
+                if (!log.read(&key[0], length)) break;
+                if (checksum(key.data(), key.size(), checksum(header, 9)) != sum) break;
+                if (header[0] == OP_INSERT) tree.insert(key, value);
+                else if (header[0] == OP_DEL) tree.del(key);
+                else break;
+                valid += HEADER_SIZE + length;
+                sinceCheckpoint++;
+            }
+        }
+
+        logFd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (logFd < 0) throw runtime_error("DurableTRIETree: cannot open " + logPath);
+        if (::ftruncate(logFd, valid) != 0) throw runtime_error("DurableTRIETree: cannot truncate " + logPath);
+    }
+
+public:
+    /**
+     * Konstruktor, odtwarza stan drzewa z migawki i dziennika
+     *
+     * @param path - przedrostek ścieżki plików, dziennik to <path>.wal, migawka to <path>.snapshot
+     * @param policy - polityka wywoływania fsync
+     * @param batchSize - największa ilość operacji zapisywanych do dziennika jedną grupą
+     * @param checkpointInterval - co ile operacji wykonywać migawkę, 0 wyłącza automatyczne migawki
+     */
+    explicit DurableTRIETree(const string &path, FsyncPolicy policy = FSYNC_ON_COMMIT, int batchSize = 64,
+                             int checkpointInterval = 1000000)
+            : logPath(path + ".wal"), checkpointPath(path + ".snapshot"), policy(policy), batchSize(batchSize),
+              checkpointInterval(checkpointInterval) {
+        recover();
+    }
+
+    DurableTRIETree(const DurableTRIETree &) = delete;
+    DurableTRIETree &operator=(const DurableTRIETree &) = delete;
+
+    /**
+     * Destruktor, zapisuje operacje pozostałe w kolejce i zamyka dziennik
+     */
+    ~DurableTRIETree() {
+        try {
+            unique_lock<mutex> guard(lock);
+            await(guard, appended);
+        } catch (const exception &) {
+        }
+        if (logFd >= 0) ::close(logFd);
+    }
+
+    /**
+     * Służy do wstawienia klucza; wraca gdy operacja jest zapisana w dzienniku i zastosowana do drzewa
+     *
+     * jeśli zapis dziennika się nie powiedzie rzuca wyjątek, a operacja nie jest stosowana do drzewa;
+     * pozostaje w kolejce i zostanie zapisana razem z następną grupą lub przez commit()
+     */
+    void insert(const string &key, int value) {
+        if (value == 0) {
+            del(key);
+            return;
+        }
+        log(OP_INSERT, key, value);
+    }
+
+    void del(const string &key) {
+        log(OP_DEL, key, 0);
+    }
+
+    /**
+     * Służy do zapisania do dziennika operacji pozostawionych w kolejce przez nieudany zapis
+     */
+    void commit() {
+        unique_lock<mutex> guard(lock);
+        await(guard, appended);
+    }
+
+    /**
+     * Służy do wymuszenia zapisania migawki i wyczyszczenia dziennika
+     */
+    void checkpoint() {
+        unique_lock<mutex> guard(lock);
+        checkpointLocked(guard);
+    }
+
+    int get(const string &key) {
+        lock_guard<mutex> guard(lock);
+        return tree.get(key);
+    }
+
+    bool contains(const string &key) {
+        lock_guard<mutex> guard(lock);
+        return tree.contains(key);
+    }
+
+    string longestPrefixOf(const string &query) {
+        lock_guard<mutex> guard(lock);
+        return tree.longestPrefixOf(query);
+    }
+
+    vector<string> keysWithPrefix(const string &prefix) {
+        lock_guard<mutex> guard(lock);
+        return tree.keysWithPrefix(prefix);
+    }
+
+    int size() {
+        lock_guard<mutex> guard(lock);
+        return tree.size();
+    }
+};
+
+/**
+ * Niezmienne, zwarte drzewo TRIE
+ *
+ * Węzły są przechowywane w jednej tablicy w kolejności przejścia w głąb (preorder), a krawędzie każdego węzła
+ * zajmują ciągły fragment tablic labels/children posortowany po literze. Zamiast 256 wskaźników na węzeł
+ * przechowujemy tylko istniejące krawędzie, dzięki czemu całe drzewo zajmuje niewiele pamięci
+ * i dobrze korzysta z pamięci podręcznej procesora.
+ */
+class FrozenTRIE {
+private:
+    struct FrozenNode {
+        int value;
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+    };
+
+    vector<FrozenNode> nodes;
+    vector<unsigned char> labels;
+    vector<uint32_t> children;
+    int count = 0;
+
+    /**
+     * Służy do zbudowania węzła z posortowanego fragmentu par klucz-wartość
+     *
+     * @param entries - posortowane pary klucz-wartość
+     * @param lo - początek fragmentu
+     * @param hi - koniec fragmentu
+     * @param d - indeks aktualnie przetwarzanej litery, wszystkie klucze fragmentu mają wspólne pierwsze d liter
+     * @return - indeks utworzonego węzła
+     *
+     * jeśli pierwszy klucz fragmentu ma długość d to kończy się w tym węźle
+     * rezerwujemy po jednej krawędzi dla każdej grupy kluczy o tej samej literze na pozycji d
+     * budujemy rekurencyjnie dziecko dla każdej grupy
+     */
+    uint32_t build(const vector<pair<string, int>> &entries, size_t lo, size_t hi, size_t d) {
+        uint32_t index = nodes.size();
+        nodes.push_back({0, 0, 0});
+        if (lo < hi && entries[lo].first.size() == d) {
+            nodes[index].value = entries[lo].second;
+            if (entries[lo].second != 0) count++;
+            lo++;
+        }
+        uint32_t first = labels.size();
+        uint32_t edges = 0;
+        for (size_t i = lo; i < hi;) {
+            unsigned char c = entries[i].first[d];
+            labels.push_back(c);
+            children.push_back(0);
+            edges++;
+            while (i < hi && (unsigned char) entries[i].first[d] == c) i++;
+        }
+        nodes[index].firstEdge = first;
+        nodes[index].edgeCount = edges;
+        for (uint32_t e = 0; e < edges; e++) {
+            size_t end = lo;
+            while (end < hi && (unsigned char) entries[end].first[d] == labels[first + e]) end++;
+            uint32_t child = build(entries, lo, end, d + 1);
+            children[first + e] = child;
+            lo = end;
+        }
+        return index;
+    }
+
+    /**
+     * Służy do znalezienia dziecka węzła x odpowiadającego literze c
+     *
+     * @return - indeks dziecka, lub -1 jeśli nie istnieje
+     */
+    long child(uint32_t x, unsigned char c) const {
+        const unsigned char *begin = labels.data() + nodes[x].firstEdge;
+        const unsigned char *end = begin + nodes[x].edgeCount;
+        const unsigned char *edge = lower_bound(begin, end, c);
+        if (edge == end || *edge != c) return -1;
+        return children[edge - labels.data()];
+    }
+
+    long find(const string &key) const {
+        if (nodes.empty()) return -1;
+        long x = 0;
+        for (size_t d = 0; x >= 0 && d < key.size(); d++)
+            x = child(x, key[d]);
+        return x;
+    }
+
+    void collect(uint32_t x, string &key, vector<pair<string, int>> &queue) const {
+        if (nodes[x].value != 0) queue.emplace_back(key, nodes[x].value);
+        for (uint32_t e = nodes[x].firstEdge; e < nodes[x].firstEdge + nodes[x].edgeCount; e++) {
+            key.push_back((char) labels[e]);
+            collect(children[e], key, queue);
+            key.pop_back();
+        }
+    }
+
+public:
+    /**
+     * Konstruktor, buduje drzewo z par klucz-wartość posortowanych rosnąco po kluczu, bez powtórzeń
+     */
+    explicit FrozenTRIE(const vector<pair<string, int>> &entries = {}) {
+        build(entries, 0, entries.size(), 0);
+    }
+
+    int get(const string &key) const {
+        long x = find(key);
+        if (x < 0) return 0;
+        return nodes[x].value;
+    }
+
+    /**
+     * Służy do wyznaczenia długości wszystkich przedrostków zapytania które są kluczami
+     *
+     * @param query - zapytanie
+     * @param lengths - długości pasujących przedrostków, rosnąco
+     */
+    void matchLengths(const string &query, vector<int> &lengths) const {
+        long x = nodes.empty() ? -1 : 0;
+        for (size_t d = 0; x >= 0; d++) {
+            if (nodes[x].value != 0) lengths.push_back(d);
+            if (d == query.size()) break;
+            x = child(x, query[d]);
+        }
+    }
+
+    /**
+     * Służy do zebrania par klucz-wartość dla danego przedrostka, w porządku leksykograficznym
+     */
+    vector<pair<string, int>> entriesWithPrefix(const string &prefix) const {
+        vector<pair<string, int>> queue;
+        long x = find(prefix);
+        string key = prefix;
+        if (x >= 0) collect(x, key, queue);
+        return queue;
+    }
+
+    int size() const {
+        return count;
+    }
+};
+
+/**
+ * Zminimalizowany skierowany acykliczny graf słów (DAWG)
+ *
+ * W odróżnieniu od drzewa TRIE, które współdzieli tylko przedrostki, równoważne poddrzewa (te same przyrostki,
+ * np. "-owany") są przechowywane raz. Graf jest budowany przyrostowo z posortowanych kluczy (algorytm Daciuka):
+ * po każdym kluczu węzły ścieżki poprzedniego klucza, które nie mogą już się zmienić, są porównywane z rejestrem
+ * węzłów i zastępowane istniejącym równoważnym węzłem. Ponieważ wiele kluczy kończy się w tym samym węźle,
+ * wartości nie mogą być przechowywane w węzłach - każda krawędź pamięta ilość kluczy, które omijamy idąc nią,
+ * dzięki czemu ścieżka klucza wyznacza jego numer w porządku leksykograficznym, a numer indeksuje tablicę wartości.
+ * Węzły i krawędzie są przechowywane w tablicach jak w FrozenTRIE.
+ */
+class DAWG {
+private:
+    struct DAWGNode {
+        bool final;
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+        uint32_t words;
+    };
+
+    /**
+     * Węzeł ścieżki ostatnio wstawionego klucza, jeszcze nie zarejestrowany; ostatnia krawędź prowadzi do kolejnego węzła ścieżki
+     */
+    struct PendingNode {
+        bool final = false;
+        vector<unsigned char> labels;
+        vector<uint32_t> children;
+    };
+
+    vector<DAWGNode> nodes;
+    vector<unsigned char> labels;
+    vector<uint32_t> children;
+    vector<uint32_t> skips;
+    vector<int> values;
+    uint32_t root = 0;
+
+    /**
+     * Służy do zarejestrowania węzła, którego dzieci są już zarejestrowane
+     *
+     * @param x - węzeł
+     * @param registry - rejestr węzłów, kluczem jest opis węzła (czy kończy się w nim klucz, litery krawędzi i dzieci)
+     * @return - indeks równoważnego węzła z rejestru lub nowo dodanego węzła
+     *
+     * dla nowego węzła wyliczamy ilość kluczy w jego poddrzewie i dla każdej krawędzi ilość kluczy, które omijamy idąc nią
+     */
+    uint32_t add(const PendingNode &x, unordered_map<string, uint32_t> &registry) {
+        string signature(1, x.final ? '1' : '0');
+        for (size_t e = 0; e < x.labels.size(); e++) {
+            signature.push_back((char) x.labels[e]);
+            signature.append((const char *) &x.children[e], sizeof(uint32_t));
+        }
+        auto found = registry.find(signature);
+        if (found != registry.end()) return found->second;
+
+        uint32_t words = x.final ? 1 : 0;
+        uint32_t first = labels.size();
+        for (size_t e = 0; e < x.labels.size(); e++) {
+            labels.push_back(x.labels[e]);
+            children.push_back(x.children[e]);
+            skips.push_back(words);
+            words += nodes[x.children[e]].words;
+        }
+        uint32_t index = nodes.size();
+        nodes.push_back({x.final, first, (uint32_t) x.labels.size(), words});
+        registry.emplace(signature, index);
+        return index;
+    }
+
+    /**
+     * Służy do zarejestrowania węzłów ścieżki głębszych niż depth
+     *
+     * zaczynając od najgłębszego węzła rejestrujemy go, usuwamy ze ścieżki i podpinamy pod ostatnią krawędź rodzica
+     */
+    void minimize(vector<PendingNode> &path, size_t depth, unordered_map<string, uint32_t> &registry) {
+        while (path.size() > depth + 1) {
+            uint32_t index = add(path.back(), registry);
+            path.pop_back();
+            path.back().children.back() = index;
+        }
+    }
+
+    void build(const vector<pair<string, int>> &entries) {
+        unordered_map<string, uint32_t> registry;
+        vector<PendingNode> path(1);
+        const string *previous = nullptr;
+        for (auto &entry : entries) {
+            const string &key = entry.first;
+            if (entry.second == 0) continue;
+            if (previous != nullptr && !(*previous < key))
+                throw invalid_argument("DAWG: keys must be sorted and unique");
+            size_t common = 0;
+            if (previous != nullptr)
+                while (common < previous->size() && common < key.size() && (*previous)[common] == key[common]) common++;
+            minimize(path, common, registry);
+            for (size_t d = common; d < key.size(); d++) {
+                path.back().labels.push_back(key[d]);
+                path.back().children.push_back(0);
+                path.emplace_back();
+            }
+            path.back().final = true;
+            values.push_back(entry.second);
+            previous = &key;
+        }
+        minimize(path, 0, registry);
+        root = add(path[0], registry);
+    }
+
+    /**
+     * Służy do znalezienia krawędzi węzła x odpowiadającej literze c
+     *
+     * @return - indeks krawędzi, lub -1 jeśli nie istnieje
+     */
+    long edge(uint32_t x, unsigned char c) const {
+        const unsigned char *begin = labels.data() + nodes[x].firstEdge;
+        const unsigned char *end = begin + nodes[x].edgeCount;
+        const unsigned char *found = lower_bound(begin, end, c);
+        if (found == end || *found != c) return -1;
+        return found - labels.data();
+    }
+
+    /**
+     * Służy do zejścia po literach klucza
+     *
+     * @param index - ilość kluczy mniejszych od kluczy poddrzewa znalezionego węzła
+     * @return - indeks węzła, lub -1 jeśli klucz nie jest przedrostkiem żadnego klucza
+     */
+    long find(const string &key, uint32_t &index) const {
+        long x = root;
+        index = 0;
+        for (size_t d = 0; d < key.size(); d++) {
+            long e = edge(x, key[d]);
+            if (e < 0) return -1;
+            index += skips[e];
+            x = children[e];
+        }
+        return x;
+    }
+
+    void collect(uint32_t x, string &key, vector<string> &queue) const {
+        if (nodes[x].final) queue.push_back(key);
+        for (uint32_t e = nodes[x].firstEdge; e < nodes[x].firstEdge + nodes[x].edgeCount; e++) {
+            key.push_back((char) labels[e]);
+            collect(children[e], key, queue);
+            key.pop_back();
+        }
+    }
+
+    void collect(uint32_t x, string &prefix, const string &pat, vector<string> &q) const {
+        if (prefix.length() == pat.length()) {
+            if (nodes[x].final) q.push_back(prefix);
+            return;
+        }
+        unsigned char next = pat[prefix.length()];
+        for (uint32_t e = nodes[x].firstEdge; e < nodes[x].firstEdge + nodes[x].edgeCount; e++) {
+            if (next != '.' && next != labels[e]) continue;
+            prefix.push_back((char) labels[e]);
+            collect(children[e], prefix, pat, q);
+            prefix.pop_back();
+        }
+    }
+
+public:
+    /**
+     * Konstruktor, buduje graf z par klucz-wartość posortowanych rosnąco po kluczu, bez powtórzeń;
+     * pary z wartością 0 są pomijane
+     */
+    explicit DAWG(const vector<pair<string, int>> &entries = {}) {
+        build(entries);
+    }
+
+    /**
+     * Konstruktor, buduje graf z kluczy gotowego drzewa TRIE (przechodzonych w porządku leksykograficznym)
+     */
+    explicit DAWG(TRIETree &tree) {
+        vector<pair<string, int>> entries;
+        entries.reserve(tree.size());
+        tree.forEach("", [&entries](const string &key, int &value) {
+            entries.emplace_back(key, value);
+            return true;
+        });
+        build(entries);
+    }
+
+    /**
+     * Służy do zwracania wartości powiązanej z kluczem
+     *
+     * schodzimy po literach klucza sumując ilości omijanych kluczy zapisane na krawędziach;
+     * jeśli w węźle końcowym kończy się klucz, suma jest jego numerem w tablicy wartości
+     */
+    int get(const string &key) const {
+        uint32_t index;
+        long x = find(key, index);
+        if (x < 0 || !nodes[x].final) return 0;
+        return values[index];
+    }
+
+    bool contains(const string &key) const {
+        return get(key) != 0;
+    }
+
+    string longestPrefixOf(const string &query) const {
+        size_t length = 0;
+        long x = root;
+        for (size_t d = 0;; d++) {
+            if (nodes[x].final) length = d;
+            if (d == query.size()) break;
+            long e = edge(x, query[d]);
+            if (e < 0) break;
+            x = children[e];
+        }
+        return query.substr(0, length);
+    }
+
+    vector<string> keys() const {
+        return keysWithPrefix("");
+    }
+
+    vector<string> keysWithPrefix(const string &prefix) const {
+        vector<string> queue;
+        uint32_t index;
+        long x = find(prefix, index);
+        string key = prefix;
+        if (x >= 0) collect(x, key, queue);
+        return queue;
+    }
+
+    vector<string> keysThatMatch(const string &pat) const {
+        vector<string> q;
+        string prefix;
+        collect(root, prefix, pat, q);
+        return q;
+    }
+
+    int size() const {
+        return nodes[root].words;
+    }
+
+    size_t nodeCount() const {
+        return nodes.size();
+    }
+
+    /**
+     * Służy do oszacowania pamięci zajmowanej przez graf
+     *
+     * @return - rozmiar tablic węzłów, krawędzi i wartości w bajtach
+     */
+    size_t memoryUsage() const {
+        return nodes.size() * sizeof(DAWGNode) + labels.size() * (sizeof(unsigned char) + 2 * sizeof(uint32_t))
+               + values.size() * sizeof(int);
+    }
+};
+
+/**
+ * Nagłówek pliku z zapisanym przetwornikiem FST
+ */
+const char FST_MAGIC[8] = {'T', 'R', 'I', 'E', 'F', 'S', 'T', '1'};
+
+/**
+ * Minimalny acykliczny przetwornik skończony (FST) odwzorowujący klucze na wartości
+ *
+ * Tak jak w DAWG równoważne poddrzewa są współdzielone, ale wartości nie są przechowywane osobno - są rozłożone
+ * na krawędzie: wartość klucza to suma wyjść krawędzi na jego ścieżce i wyjścia końcowego węzła. Podczas budowy
+ * z posortowanych kluczy wspólna część wyjść (minimum) jest przesuwana jak najbliżej korzenia, więc poddrzewa
+ * różniące się tylko stałym przesunięciem wartości stają się równoważne i są współdzielone.
+ * Wyjścia są liczbami 32-bitowymi bez znaku sumowanymi modulo 2^32, dzięki czemu obsługiwane są też wartości ujemne.
+ *
+ * Przetwornik jest przechowywany w jednym buforze (nagłówek, węzły, cele krawędzi, wyjścia krawędzi, litery krawędzi),
+ * który można zapisać metodą save i później zmapować do pamięci metodą open bez żadnego przetwarzania.
+ * Format używa natywnej kolejności bajtów.
+ */
+class FST {
+private:
+    struct FSTHeader {
+        char magic[8];
+        uint32_t nodeCount;
+        uint32_t edgeCount;
+        uint32_t root;
+        uint32_t count;
+    };
+
+    struct FSTNode {
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+        uint32_t final;
+        uint32_t finalOutput;
+    };
+
+    /**
+     * Węzeł ścieżki ostatnio wstawionego klucza, jeszcze nie zarejestrowany
+     */
+    struct PendingNode {
+        bool final = false;
+        long long finalOutput = 0;
+        vector<unsigned char> labels;
+        vector<uint32_t> targets;
+        vector<long long> outputs;
+    };
+
+    /**
+     * Węzły i krawędzie budowanego przetwornika, przed zapisaniem do bufora
+     */
+    struct Builder {
+        vector<FSTNode> nodes;
+        vector<unsigned char> labels;
+        vector<uint32_t> targets;
+        vector<uint32_t> outputs;
+        unordered_map<string, uint32_t> registry;
+    };
+
+    string buffer;
+    void *mapping = nullptr;
+    size_t mappingLength = 0;
+    const FSTHeader *header = nullptr;
+    const FSTNode *nodes = nullptr;
+    const uint32_t *targets = nullptr;
+    const uint32_t *outputs = nullptr;
+    const unsigned char *labels = nullptr;
+
+    /**
+     * Służy do zarejestrowania węzła, którego dzieci są już zarejestrowane
+     *
+     * @return - indeks równoważnego węzła z rejestru lub nowo dodanego węzła
+     */
+    static uint32_t add(const PendingNode &x, Builder &builder) {
+        uint32_t finalOutput = x.final ? (uint32_t) x.finalOutput : 0;
+        string signature(1, x.final ? '1' : '0');
+        signature.append((const char *) &finalOutput, sizeof(finalOutput));
+        for (size_t e = 0; e < x.labels.size(); e++) {
+            uint32_t output = (uint32_t) x.outputs[e];
+            signature.push_back((char) x.labels[e]);
+            signature.append((const char *) &x.targets[e], sizeof(uint32_t));
+            signature.append((const char *) &output, sizeof(output));
+        }
+        auto found = builder.registry.find(signature);
+        if (found != builder.registry.end()) return found->second;
+
+        uint32_t index = builder.nodes.size();
+        builder.nodes.push_back({(uint32_t) builder.labels.size(), (uint32_t) x.labels.size(), x.final, finalOutput});
+        for (size_t e = 0; e < x.labels.size(); e++) {
+            builder.labels.push_back(x.labels[e]);
+            builder.targets.push_back(x.targets[e]);
+            builder.outputs.push_back((uint32_t) x.outputs[e]);
+        }
+        builder.registry.emplace(signature, index);
+        return index;
+    }
+
+    static void minimize(vector<PendingNode> &path, size_t depth, Builder &builder) {
+        while (path.size() > depth + 1) {
+            uint32_t index = add(path.back(), builder);
+            path.pop_back();
+            path.back().targets.back() = index;
+        }
+    }
+
+    /**
+     * Służy do zbudowania przetwornika z posortowanych par klucz-wartość
+     *
+     * rejestrujemy węzły ścieżki poprzedniego klucza głębsze niż wspólny przedrostek i dopisujemy nowe węzły
+     * idąc od korzenia po wspólnym przedrostku zostawiamy na każdej krawędzi minimum z jej wyjścia i pozostałej części
+     *  wartości, a nadwyżkę krawędzi przesuwamy na wszystkie wyjścia (oraz wyjście końcowe) następnego węzła
+     * resztę wartości umieszczamy na pierwszej nowej krawędzi, lub na wyjściu końcowym jeśli nowych krawędzi nie ma
+     * na końcu zapisujemy węzły i krawędzie do bufora
+     */
+    void build(const vector<pair<string, int>> &entries) {
+        Builder builder;
+        vector<PendingNode> path(1);
+        const string *previous = nullptr;
+        uint32_t count = 0;
+        for (auto &entry : entries) {
+            const string &key = entry.first;
+            if (entry.second == 0) continue;
+            if (previous != nullptr && !(*previous < key))
+                throw invalid_argument("FST: keys must be sorted and unique");
+            size_t common = 0;
+            if (previous != nullptr)
+                while (common < previous->size() && common < key.size() && (*previous)[common] == key[common]) common++;
+            minimize(path, common, builder);
+            for (size_t d = common; d < key.size(); d++) {
+                path.back().labels.push_back(key[d]);
+                path.back().targets.push_back(0);
+                path.back().outputs.push_back(0);
+                path.emplace_back();
+            }
+            path.back().final = true;
+
+            long long rest = entry.second;
+            for (size_t d = 0; d < common; d++) {
+                long long &output = path[d].outputs.back();
+                long long shared = min(output, rest);
+                long long pushed = output - shared;
+                output = shared;
+                rest -= shared;
+                if (pushed == 0) continue;
+                PendingNode &next = path[d + 1];
+                for (auto &o : next.outputs) o += pushed;
+                if (next.final) next.finalOutput += pushed;
+            }
+            if (key.size() > common) path[common].outputs.back() = rest;
+            else path[common].finalOutput = rest;
+            previous = &key;
+            count++;
+        }
+        minimize(path, 0, builder);
+        uint32_t root = add(path[0], builder);
+
+        FSTHeader top;
+        memcpy(top.magic, FST_MAGIC, sizeof(top.magic));
+        top.nodeCount = builder.nodes.size();
+        top.edgeCount = builder.labels.size();
+        top.root = root;
+        top.count = count;
+        buffer.append((const char *) &top, sizeof(top));
+        buffer.append((const char *) builder.nodes.data(), builder.nodes.size() * sizeof(FSTNode));
+        buffer.append((const char *) builder.targets.data(), builder.targets.size() * sizeof(uint32_t));
+        buffer.append((const char *) builder.outputs.data(), builder.outputs.size() * sizeof(uint32_t));
+        buffer.append((const char *) builder.labels.data(), builder.labels.size());
+        attach(buffer.data(), buffer.size());
+    }
+
+    /**
+     * Służy do ustawienia wskaźników na sekcje bufora
+     *
+     * @return - false jeśli bufor nie zawiera poprawnego nagłówka, jest krótszy niż wynika z nagłówka,
+     * albo któryś węzeł wskazuje krawędzie lub węzły spoza bufora - wskaźniki pozostają wtedy bez zmian
+     *
+     * węzły są zapisywane po swoich dzieciach, więc każda krawędź musi prowadzić do węzła o mniejszym indeksie
+     * dzięki temu odrzucamy też cykle, na których zapętliłoby się przeszukiwanie
+     */
+    bool attach(const char *data, size_t length) {
+        if (length < sizeof(FSTHeader) || memcmp(data, FST_MAGIC, sizeof(FST_MAGIC)) != 0) return false;
+        const FSTHeader *top = (const FSTHeader *) data;
+        size_t expected = sizeof(FSTHeader) + (size_t) top->nodeCount * sizeof(FSTNode)
+                          + (size_t) top->edgeCount * (2 * sizeof(uint32_t) + 1);
+        if (length < expected || top->root >= top->nodeCount) return false;
+        const FSTNode *table = (const FSTNode *) (data + sizeof(FSTHeader));
+        const uint32_t *edges = (const uint32_t *) (table + top->nodeCount);
+        for (uint32_t x = 0; x < top->nodeCount; x++) {
+            if (table[x].firstEdge > top->edgeCount || top->edgeCount - table[x].firstEdge < table[x].edgeCount)
+                return false;
+            for (uint32_t e = table[x].firstEdge; e < table[x].firstEdge + table[x].edgeCount; e++)
+                if (edges[e] >= x) return false;
+        }
+        header = top;
+        nodes = table;
+        targets = edges;
+        outputs = targets + top->edgeCount;
+        labels = (const unsigned char *) (outputs + top->edgeCount);
+        return true;
+    }
+
+    long edge(uint32_t x, unsigned char c) const {
+        const unsigned char *begin = labels + nodes[x].firstEdge;
+        const unsigned char *end = begin + nodes[x].edgeCount;
+        const unsigned char *found = lower_bound(begin, end, c);
+        if (found == end || *found != c) return -1;
+        return found - labels;
+    }
+
+    void collect(uint32_t x, string &key, uint32_t sum, vector<pair<string, int>> &queue) const {
+        if (nodes[x].final) queue.emplace_back(key, (int) (sum + nodes[x].finalOutput));
+        for (uint32_t e = nodes[x].firstEdge; e < nodes[x].firstEdge + nodes[x].edgeCount; e++) {
+            key.push_back((char) labels[e]);
+            collect(targets[e], key, sum + outputs[e], queue);
+            key.pop_back();
+        }
+    }
+
+public:
+    /**
+     * Konstruktor, buduje przetwornik z par klucz-wartość posortowanych rosnąco po kluczu, bez powtórzeń;
+     * pary z wartością 0 są pomijane
+     */
+    explicit FST(const vector<pair<string, int>> &entries = {}) {
+        build(entries);
+    }
+
+    /**
+     * Konstruktor, buduje przetwornik z kluczy gotowego drzewa TRIE
+     */
+    explicit FST(TRIETree &tree) {
+        vector<pair<string, int>> entries;
+        entries.reserve(tree.size());
+        tree.forEach("", [&entries](const string &key, int &value) {
+            entries.emplace_back(key, value);
+            return true;
+        });
+        build(entries);
+    }
+
+    FST(const FST &) = delete;
+    FST &operator=(const FST &) = delete;
+
+    ~FST() {
+        if (mapping != nullptr) ::munmap(mapping, mappingLength);
+    }
+
+    /**
+     * Służy do zapisania przetwornika do strumienia binarnego, w postaci którą można zmapować metodą open
+     */
+    void save(ostream &out) const {
+        out.write((const char *) header, sizeof(FSTHeader) + (size_t) header->nodeCount * sizeof(FSTNode)
+                                         + (size_t) header->edgeCount * (2 * sizeof(uint32_t) + 1));
+    }
+
+    /**
+     * Służy do zmapowania do pamięci przetwornika zapisanego metodą save, zastępuje aktualną zawartość
+     *
+     * @param path - ścieżka pliku
+     * @return - false jeśli pliku nie da się otworzyć lub nie zawiera przetwornika, zawartość pozostaje wtedy bez zmian
+     */
+    bool open(const string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        size_t length = info.st_size;
+        void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        if (!attach((const char *) mapped, length)) {
+            ::munmap(mapped, length);
+            return false;
+        }
+        if (mapping != nullptr) ::munmap(mapping, mappingLength);
+        buffer.clear();
+        buffer.shrink_to_fit();
+        mapping = mapped;
+        mappingLength = length;
+        return true;
+    }
+
+    /**
+     * Służy do zwracania wartości powiązanej z kluczem
+     *
+     * schodzimy po literach klucza sumując wyjścia krawędzi; jeśli w węźle końcowym kończy się klucz
+     * dodajemy jego wyjście końcowe
+     */
+    int get(const string &key) const {
+        uint32_t x = header->root;
+        uint32_t sum = 0;
+        for (unsigned char c : key) {
+            long e = edge(x, c);
+            if (e < 0) return 0;
+            sum += outputs[e];
+            x = targets[e];
+        }
+        if (!nodes[x].final) return 0;
+        return (int) (sum + nodes[x].finalOutput);
+    }
+
+    bool contains(const string &key) const {
+        return get(key) != 0;
+    }
+
+    /**
+     * Służy do zebrania par klucz-wartość dla danego przedrostka, w porządku leksykograficznym
+     */
+    vector<pair<string, int>> entriesWithPrefix(const string &prefix) const {
+        vector<pair<string, int>> queue;
+        uint32_t x = header->root;
+        uint32_t sum = 0;
+        for (unsigned char c : prefix) {
+            long e = edge(x, c);
+            if (e < 0) return queue;
+            sum += outputs[e];
+            x = targets[e];
+        }
+        string key = prefix;
+        collect(x, key, sum, queue);
+        return queue;
+    }
+
+    int size() const {
+        return header->count;
+    }
+
+    size_t nodeCount() const {
+        return header->nodeCount;
+    }
+
+    /**
+     * Służy do zwrócenia rozmiaru bufora przetwornika w bajtach
+     */
+    size_t memoryUsage() const {
+        return sizeof(FSTHeader) + (size_t) header->nodeCount * sizeof(FSTNode)
+               + (size_t) header->edgeCount * (2 * sizeof(uint32_t) + 1);
+    }
+};
+
+/**
+ * Dwupoziomowe drzewo TRIE w stylu LSM - mała modyfikowalna delta nad dużą niezmienną bazą
+ *
+ * insert i del trafiają wyłącznie do delty (TRIETree z wartościami oraz TRIETree z nagrobkami usuniętych kluczy),
+ * a odczyty sprawdzają kolejno deltę, deltę w trakcie scalania i bazę FrozenTRIE. Wątek w tle co interval
+ * (lub gdy delta przekroczy deltaLimit operacji) odkłada aktualną deltę, scala ją z bazą do nowego FrozenTRIE
+ * bez blokowania odczytów i zapisów, a następnie podmienia bazę.
+ */
+class LSMTRIETree {
+private:
+    struct Delta {
+        TRIETree values;
+        TRIETree tombstones;
+        int operations = 0;
+    };
+
+    shared_ptr<const FrozenTRIE> base;
+    unique_ptr<Delta> active;
+    unique_ptr<Delta> flushing;
+    int live = 0;
+    int deltaLimit;
+    chrono::milliseconds interval;
+    mutable shared_timed_mutex lock;
+    mutex compactionLock;
+    mutex wakeLock;
+    condition_variable wake;
+    bool stopping = false;
+    thread compactor;
+
+    /**
+     * Służy do sprawdzenia stanu klucza w jednej delcie
+     *
+     * @return - 1 jeśli klucz ma wartość (zapisaną w value), -1 jeśli klucz został usunięty, 0 jeśli delta o nim nie wie
+     */
+    static int probe(Delta *delta, const string &key, int &value) {
+        if (delta == nullptr) return 0;
+        value = delta->values.get(key);
+        if (value != 0) return 1;
+        if (delta->tombstones.contains(key)) return -1;
+        return 0;
+    }
+
+    int lookup(const string &key) const {
+        int value = 0;
+        for (Delta *delta : {active.get(), flushing.get()}) {
+            int state = probe(delta, key, value);
+            if (state == 1) return value;
+            if (state == -1) return 0;
+        }
+        return base->get(key);
+    }
+
+    static void matchLengths(TRIETree &tree, const string &query, vector<int> &lengths) {
+        Node *x = tree.getRoot();
+        for (size_t d = 0; x != nullptr; d++) {
+            if (x->value != 0) lengths.push_back(d);
+            if (d == query.size()) break;
+            x = x->next[(unsigned char) query[d]];
+        }
+    }
+
+    void compactionLoop() {
+        unique_lock<mutex> guard(wakeLock);
+        while (!stopping) {
+            wake.wait_for(guard, interval);
+            if (stopping) break;
+            guard.unlock();
+            mergeDelta();
+            guard.lock();
+        }
+    }
+
+public:
+    /**
+     * Konstruktor, uruchamia wątek scalający
+     *
+     * @param deltaLimit - ilość operacji w delcie po której wątek scalający jest budzony przed upływem interval
+     * @param interval - co ile wątek scalający sprawdza deltę
+     */
+    explicit LSMTRIETree(int deltaLimit = 65536, chrono::milliseconds interval = chrono::milliseconds(1000))
+            : base(make_shared<FrozenTRIE>()), active(new Delta()), deltaLimit(deltaLimit), interval(interval) {
+        compactor = thread(&LSMTRIETree::compactionLoop, this);
+    }
+
+    LSMTRIETree(const LSMTRIETree &) = delete;
+    LSMTRIETree &operator=(const LSMTRIETree &) = delete;
+
+    /**
+     * Destruktor, zatrzymuje wątek scalający
+     */
+    ~LSMTRIETree() {
+        {
+            lock_guard<mutex> guard(wakeLock);
+            stopping = true;
+        }
+        wake.notify_one();
+        compactor.join();
+    }
+
+    void insert(const string &key, int value) {
+        if (value == 0) {
+            del(key);
+            return;
+        }
+        unique_lock<shared_timed_mutex> guard(lock);
+        if (lookup(key) == 0) live++;
+        active->values.insert(key, value);
+        active->tombstones.del(key);
+        if (++active->operations == deltaLimit) wake.notify_one();
+    }
+
+    void del(const string &key) {
+        unique_lock<shared_timed_mutex> guard(lock);
+        if (lookup(key) != 0) live--;
+        active->values.del(key);
+        active->tombstones.insert(key, 1);
+        if (++active->operations == deltaLimit) wake.notify_one();
+    }
+
+    int get(const string &key) const {
+        shared_lock<shared_timed_mutex> guard(lock);
+        return lookup(key);
+    }
+
+    bool contains(const string &key) const {
+        return get(key) != 0;
+    }
+
+    /**
+     * Służy do wyszukiwania najdłuższego przedrostka danego słowa, uwzględniając obie warstwy
+     *
+     * zbieramy długości przedrostków będących kluczami w którejkolwiek warstwie
+     * sprawdzamy je od najdłuższej i zwracamy pierwszą która nie została przesłonięta nagrobkiem
+     */
+    string longestPrefixOf(const string &query) const {
+        shared_lock<shared_timed_mutex> guard(lock);
+        vector<int> lengths;
+        base->matchLengths(query, lengths);
+        for (Delta *delta : {active.get(), flushing.get()})
+            if (delta != nullptr)
+                matchLengths(delta->values, query, lengths);
+        sort(lengths.begin(), lengths.end());
+        for (auto length = lengths.rbegin(); length != lengths.rend(); ++length)
+            if (lookup(query.substr(0, *length)) != 0)
+                return query.substr(0, *length);
+        return "";
+    }
+
+    /**
+     * Służy do zebrania kluczy z danym przedrostkiem ze wszystkich warstw, w porządku leksykograficznym
+     *
+     * scalamy posortowane listy kluczy z warstw i pomijamy klucze przesłonięte nagrobkami
+     */
+    vector<string> keysWithPrefix(const string &prefix) const {
+        shared_lock<shared_timed_mutex> guard(lock);
+        vector<string> candidates;
+        for (auto &entry : base->entriesWithPrefix(prefix))
+            candidates.push_back(entry.first);
+        for (Delta *delta : {active.get(), flushing.get()}) {
+            if (delta == nullptr) continue;
+            vector<string> keys = delta->values.keysWithPrefix(prefix);
+            vector<string> merged;
+            merge(candidates.begin(), candidates.end(), keys.begin(), keys.end(), back_inserter(merged));
+            candidates.swap(merged);
+        }
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+        vector<string> queue;
+        for (auto &key : candidates)
+            if (lookup(key) != 0)
+                queue.push_back(key);
+        return queue;
+    }
+
+    vector<string> keys() const {
+        return keysWithPrefix("");
+    }
+
+    /**
+     * Służy do zwrócenia ilości kluczy
+     *
+     * licznik jest aktualizowany przez insert i del, które sprawdzają w delcie i bazie czy klucz już istniał
+     */
+    int size() const {
+        shared_lock<shared_timed_mutex> guard(lock);
+        return live;
+    }
+
+    /**
+     * Służy do scalenia delty z bazą, wywoływana przez wątek w tle lub ręcznie
+     *
+     * odkładamy aktualną deltę i zaczynamy nową - od tej chwili odłożona delta i baza są niezmienne
+     * bez blokady budujemy nową bazę scalając posortowane pary z bazy z kluczami delty i pomijając nagrobki
+     * podmieniamy bazę i zwalniamy odłożoną deltę
+     * nowa baza zawiera dokładnie klucze widoczne w starej bazie i odłożonej delcie, więc podmiana nie zmienia
+     *  zbioru kluczy i licznik kluczy pozostaje aktualny
+     */
+    void mergeDelta() {
+        lock_guard<mutex> single(compactionLock);
+        {
+            unique_lock<shared_timed_mutex> guard(lock);
+            if (active->operations == 0) return;
+            flushing = move(active);
+            active.reset(new Delta());
+        }
+
+        vector<pair<string, int>> old = base->entriesWithPrefix("");
+        vector<string> changed = flushing->values.keys();
+        vector<pair<string, int>> entries;
+        size_t i = 0, j = 0;
+        while (i < old.size() || j < changed.size()) {
+            if (j == changed.size() || (i < old.size() && old[i].first < changed[j])) {
+                if (!flushing->tombstones.contains(old[i].first)) entries.push_back(old[i]);
+                i++;
+            } else {
+                if (i < old.size() && old[i].first == changed[j]) i++;
+                entries.emplace_back(changed[j], flushing->values.get(changed[j]));
+                j++;
+            }
+        }
+        shared_ptr<const FrozenTRIE> next = make_shared<FrozenTRIE>(entries);
+
+        unique_lock<shared_timed_mutex> guard(lock);
+        base = next;
+        flushing.reset();
+    }
+};
+
+/**
+ * Tablica tras IPv4 z wyszukiwaniem najdłuższego pasującego przedrostka (LPM) w schemacie DIR-24-8
+ *
+ * Przedrostki mają dowolną długość w bitach (adres, długość) -> następny skok. Pierwsze 24 bity adresu indeksują
+ * tablicę tbl24, której pozycja zawiera od razu następny skok, albo (przedrostki dłuższe niż 24 bity) numer grupy
+ * 256 pozycji w tbl8 indeksowanej ostatnim bajtem adresu. Krótsze przedrostki są rozpisywane (leaf pushing) na wszystkie
+ * pokrywane pozycje, więc wyszukiwanie to co najwyżej dwa odczyty pamięci. Dla każdej pozycji pamiętamy długość
+ * przedrostka który ją wypełnił, aby wstawienie nie nadpisało dłuższych przedrostków, a usunięcie mogło przywrócić
+ * krótszy przedrostek pokrywający. Następny skok 0 oznacza brak trasy, tak jak wartość 0 w TRIETree.
+ */
+class IPv4RoutingTable {
+private:
+    static const uint32_t TBL8_FLAG = 0x80000000u;
+
+    vector<uint32_t> tbl24;
+    vector<uint8_t> depth24;
+    vector<uint32_t> tbl8;
+    vector<uint8_t> depth8;
+    vector<uint32_t> freeGroups;
+    unordered_map<uint64_t, uint32_t> prefixes;
+
+    static uint32_t mask(uint32_t address, int length) {
+        return length == 0 ? 0 : address & (0xFFFFFFFFu << (32 - length));
+    }
+
+    static uint64_t prefixKey(uint32_t address, int length) {
+        return ((uint64_t) address << 8) | length;
+    }
+
+    /**
+     * Służy do przydzielenia grupy tbl8 wypełnionej pozycją tbl24
+     */
+    uint32_t allocateGroup(uint32_t nexthop, uint8_t depth) {
+        uint32_t group;
+        if (freeGroups.empty()) {
+            group = tbl8.size() / 256;
+            tbl8.resize(tbl8.size() + 256);
+            depth8.resize(depth8.size() + 256);
+        } else {
+            group = freeGroups.back();
+            freeGroups.pop_back();
+        }
+        fill(tbl8.begin() + group * 256, tbl8.begin() + group * 256 + 256, nexthop);
+        fill(depth8.begin() + group * 256, depth8.begin() + group * 256 + 256, depth);
+        return group;
+    }
+
+    /**
+     * Służy do wpisania następnego skoku na wszystkie pozycje pokrywane przez przedrostek
+     *
+     * @param address - adres przedrostka (zamaskowany)
+     * @param length - długość przedrostka
+     * @param nexthop - wpisywany następny skok
+     * @param depth - długość przedrostka do którego należy wpisywany następny skok
+     *
+     * nadpisujemy tylko pozycje wypełnione przedrostkami nie dłuższymi niż length
+     * przedrostki do 24 bitów zajmują ciągły zakres tbl24 (i wszystkie grupy tbl8 do których ten zakres prowadzi)
+     * dłuższe przedrostki zajmują ciągły zakres w grupie tbl8, którą w razie potrzeby tworzymy
+     * grupę w której nie został żaden przedrostek dłuższy niż 24 bity zwijamy z powrotem do pozycji tbl24
+     */
+    void paint(uint32_t address, int length, uint32_t nexthop, uint8_t depth) {
+        if (length <= 24) {
+            uint32_t first = address >> 8, last = first + (1u << (24 - length));
+            for (uint32_t i = first; i < last; i++) {
+                if (tbl24[i] & TBL8_FLAG) {
+                    uint32_t base = (tbl24[i] & ~TBL8_FLAG) * 256;
+                    for (uint32_t j = base; j < base + 256; j++)
+                        if (depth8[j] <= length) {
+                            tbl8[j] = nexthop;
+                            depth8[j] = depth;
+                        }
+                } else if (depth24[i] <= length) {
+                    tbl24[i] = nexthop;
+                    depth24[i] = depth;
+                }
+            }
+            return;
+        }
+        uint32_t i = address >> 8;
+        if (!(tbl24[i] & TBL8_FLAG)) tbl24[i] = TBL8_FLAG | allocateGroup(tbl24[i], depth24[i]);
+        uint32_t base = (tbl24[i] & ~TBL8_FLAG) * 256;
+        uint32_t first = base + (address & 0xFF), last = first + (1u << (32 - length));
+        for (uint32_t j = first; j < last; j++)
+            if (depth8[j] <= length) {
+                tbl8[j] = nexthop;
+                depth8[j] = depth;
+            }
+        for (uint32_t j = base; j < base + 256; j++)
+            if (depth8[j] > 24) return;
+        tbl24[i] = tbl8[base];
+        depth24[i] = depth8[base];
+        freeGroups.push_back(base / 256);
+    }
+
+public:
+    IPv4RoutingTable() : tbl24(1u << 24, 0), depth24(1u << 24, 0) {}
+
+    /**
+     * Służy do wstawienia trasy
+     *
+     * @param address - adres sieci
+     * @param length - długość przedrostka w bitach, od 0 do 32
+     * @param nexthop - następny skok, od 1 do 2^31 - 1
+     */
+    void insert(uint32_t address, int length, uint32_t nexthop) {
+        if (length < 0 || length > 32) throw invalid_argument("IPv4RoutingTable: prefix length out of range");
+        if (nexthop == 0 || (nexthop & TBL8_FLAG)) throw invalid_argument("IPv4RoutingTable: nexthop out of range");
+        address = mask(address, length);
+        prefixes[prefixKey(address, length)] = nexthop;
+        paint(address, length, nexthop, length);
+    }
+
+    /**
+     * Służy do usunięcia trasy
+     *
+     * @param address - adres sieci
+     * @param length - długość przedrostka w bitach
+     *
+     * szukamy najdłuższego krótszego przedrostka pokrywającego usuwany
+     * i wpisujemy go na pozycje należące dotąd do usuwanego przedrostka
+     */
+    void del(uint32_t address, int length) {
+        if (length < 0 || length > 32) return;
+        address = mask(address, length);
+        if (prefixes.erase(prefixKey(address, length)) == 0) return;
+        for (int parent = length - 1; parent >= 0; parent--) {
+            auto found = prefixes.find(prefixKey(mask(address, parent), parent));
+            if (found != prefixes.end()) {
+                paint(address, length, found->second, parent);
+                return;
+            }
+        }
+        paint(address, length, 0, 0);
+    }
+
+    /**
+     * Służy do wyszukania następnego skoku dla adresu
+     *
+     * @return - następny skok najdłuższego pasującego przedrostka, 0 jeśli żaden nie pasuje
+     */
+    uint32_t lookup(uint32_t address) const {
+        uint32_t entry = tbl24[address >> 8];
+        if (entry & TBL8_FLAG) entry = tbl8[(entry & ~TBL8_FLAG) * 256 + (address & 0xFF)];
+        return entry;
+    }
+
+    /**
+     * Służy do wyszukania następnych skoków dla całej paczki adresów
+     *
+     * @param addresses - adresy
+     * @param count - ilość adresów
+     * @param nexthops - tablica wyników
+     *
+     * pierwszy przebieg pobiera pozycje tbl24, z wyprzedzeniem prosząc procesor o kolejne linie pamięci,
+     * drugi przebieg dociąga pozycje tbl8 dla adresów które ich wymagają
+     */
+    void lookup(const uint32_t *addresses, size_t count, uint32_t *nexthops) const {
+        const size_t ahead = 8;
+        for (size_t i = 0; i < count; i++) {
+            if (i + ahead < count) __builtin_prefetch(&tbl24[addresses[i + ahead] >> 8]);
+            nexthops[i] = tbl24[addresses[i] >> 8];
+        }
+        for (size_t i = 0; i < count; i++)
+            if (nexthops[i] & TBL8_FLAG)
+                nexthops[i] = tbl8[(nexthops[i] & ~TBL8_FLAG) * 256 + (addresses[i] & 0xFF)];
+    }
+
+    int size() const {
+        return prefixes.size();
+    }
+};
+
+typedef array<uint8_t, 16> IPv6Address;
+
+/**
+ * Tablica tras IPv6 - wielobitowe drzewo TRIE o kroku 8 bitów
+ *
+ * Każdy węzeł odpowiada jednemu bajtowi adresu, tak jak węzeł TRIETree odpowiada jednej literze. Przedrostek którego
+ * długość nie jest wielokrotnością 8 jest rozwijany na wszystkie pasujące pozycje ostatniego węzła (controlled prefix
+ * expansion), więc wyszukiwanie to co najwyżej 16 odczytów, po jednym na poziom.
+ */
+class IPv6RoutingTable {
+private:
+    struct RouteNode {
+        uint32_t nexthop[256];
+        uint8_t depth[256];
+        RouteNode *next[256];
+    };
+
+    RouteNode *root;
+    uint32_t defaultRoute = 0;
+    map<pair<IPv6Address, int>, uint32_t> prefixes;
+
+    static IPv6Address mask(IPv6Address address, int length) {
+        for (int bit = length; bit < 128; bit++)
+            address[bit / 8] &= ~(0x80 >> (bit % 8));
+        return address;
+    }
+
+    static void destroy(RouteNode *x) {
+        if (x == nullptr) return;
+        for (int c = 0; c < 256; c++)
+            destroy(x->next[c]);
+        delete x;
+    }
+
+    /**
+     * Służy do wpisania następnego skoku na pozycje węzła pokrywane przez przedrostek
+     *
+     * schodzimy po pełnych bajtach przedrostka tworząc brakujące węzły
+     * w ostatnim węźle nadpisujemy pozycje wypełnione przedrostkami nie dłuższymi niż length
+     */
+    void paint(const IPv6Address &address, int length, uint32_t nexthop, uint8_t depth) {
+        if (length == 0) {
+            defaultRoute = nexthop;
+            return;
+        }
+        int level = (length - 1) / 8;
+        RouteNode *x = root;
+        for (int b = 0; b < level; b++) {
+            if (x->next[address[b]] == nullptr) x->next[address[b]] = new RouteNode();
+            x = x->next[address[b]];
+        }
+        int first = address[level], last = first + (1 << (8 * (level + 1) - length));
+        for (int c = first; c < last; c++)
+            if (x->depth[c] <= length) {
+                x->nexthop[c] = nexthop;
+                x->depth[c] = depth;
+            }
+    }
+
+public:
+    IPv6RoutingTable() : root(new RouteNode()) {}
+
+    IPv6RoutingTable(const IPv6RoutingTable &) = delete;
+    IPv6RoutingTable &operator=(const IPv6RoutingTable &) = delete;
+
+    ~IPv6RoutingTable() {
+        destroy(root);
+    }
+
+    void insert(const IPv6Address &address, int length, uint32_t nexthop) {
+        if (length < 0 || length > 128) throw invalid_argument("IPv6RoutingTable: prefix length out of range");
+        if (nexthop == 0) throw invalid_argument("IPv6RoutingTable: nexthop out of range");
+        IPv6Address network = mask(address, length);
+        prefixes[make_pair(network, length)] = nexthop;
+        paint(network, length, nexthop, length);
+    }
+
+    /**
+     * Służy do usunięcia trasy, pozycje usuwanego przedrostka przejmuje najdłuższy krótszy przedrostek
+     * kończący się w tym samym węźle
+     */
+    void del(const IPv6Address &address, int length) {
+        if (length < 0 || length > 128) return;
+        IPv6Address network = mask(address, length);
+        if (prefixes.erase(make_pair(network, length)) == 0) return;
+        int floor = length == 0 ? 0 : (length - 1) / 8 * 8 + 1;
+        for (int parent = length - 1; parent >= floor; parent--) {
+            auto found = prefixes.find(make_pair(mask(network, parent), parent));
+            if (found != prefixes.end()) {
+                paint(network, length, found->second, parent);
+                return;
+            }
+        }
+        paint(network, length, 0, 0);
+    }
+
+    /**
+     * Służy do wyszukania następnego skoku dla adresu
+     *
+     * schodzimy po kolejnych bajtach adresu zapamiętując ostatnią niepustą pozycję
+     */
+    uint32_t lookup(const IPv6Address &address) const {
+        uint32_t best = defaultRoute;
+        RouteNode *x = root;
+        for (int b = 0; x != nullptr && b < 16; b++) {
+            if (x->nexthop[address[b]] != 0) best = x->nexthop[address[b]];
+            x = x->next[address[b]];
+        }
+        return best;
+    }
+
+    void lookup(const IPv6Address *addresses, size_t count, uint32_t *nexthops) const {
+        for (size_t i = 0; i < count; i++)
+            nexthops[i] = lookup(addresses[i]);
+    }
+
+    int size() const {
+        return prefixes.size();
+    }
+};
+
+#endif //TRIETREE_TRIETREE_H
@@ -0,0 +1,190 @@
+#include "Dictionary.h"
+#include <sys/resource.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/**
+ * Narzędzie do oceny wydajności drzewa TRIE
+ *
+ * Wczytuje słownik (Dictionary.h), a następnie odtwarza plik zapytań w N wątkach i raportuje czas budowy,
+ * maksymalne zużycie pamięci (peak RSS), przepustowość, percentyle opóźnień oraz ilość chybień TLB danych
+ * w trakcie odtwarzania (jeśli system udostępnia liczniki perf). Plik zapytań zawiera jedno
+ * zapytanie w wierszu: "GET klucz", "PREFIX przedrostek", "MATCH wzorzec" lub "LPM zapytanie".
+ * Ostatni argument wybiera sposób przydziału węzłów (heap lub hugepages), aby porównać oba tryby
+ * uruchamiamy narzędzie dwukrotnie na tych samych plikach.
+ */
+
+enum QueryType {
+    QUERY_GET,
+    QUERY_PREFIX,
+    QUERY_MATCH,
+    QUERY_LPM
+};
+
+struct Query {
+    QueryType type;
+    string argument;
+};
+
+/**
+ * Służy do wczytania pliku zapytań
+ *
+ * @return - false jeśli pliku nie udało się otworzyć lub zawiera nieznane polecenie
+ */
+static bool loadQueries(const string &path, vector<Query> &queries) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        size_t space = line.find(' ');
+        string command = line.substr(0, space);
+        string argument = space == string::npos ? "" : line.substr(space + 1);
+        if (command == "GET") queries.push_back({QUERY_GET, argument});
+        else if (command == "PREFIX") queries.push_back({QUERY_PREFIX, argument});
+        else if (command == "MATCH") queries.push_back({QUERY_MATCH, argument});
+        else if (command == "LPM") queries.push_back({QUERY_LPM, argument});
+        else {
+            cerr << "unknown query: " << line << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Służy do wykonania jednego zapytania
+ *
+ * @return - liczba zależna od wyniku, sumowana aby kompilator nie usunął zapytań
+ */
+static long run(TRIETree &tree, const Query &query) {
+    switch (query.type) {
+        case QUERY_GET:
+            return tree.get(query.argument);
+        case QUERY_PREFIX:
+            return tree.keysWithPrefix(query.argument).size();
+        case QUERY_MATCH:
+            return tree.keysThatMatch(query.argument).size();
+        case QUERY_LPM:
+            return tree.longestPrefixOf(query.argument).size();
+    }
+    return 0;
+}
+
+/**
+ * Służy do otwarcia licznika chybień TLB danych przy odczycie, liczonego dla procesu i tworzonych później wątków
+ *
+ * @return - deskryptor licznika lub -1 jeśli liczniki perf są niedostępne
+ */
+static int openTLBCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static double percentile(const vector<uint64_t> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = min(sorted.size() - 1, (size_t) (p / 100.0 * sorted.size()));
+    return sorted[index] / 1000.0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 5) {
+        cerr << "usage: " << argv[0] << " <dictionary or snapshot> <queries> [threads] [heap|hugepages]" << endl;
+        return 1;
+    }
+    int threads = argc >= 4 ? atoi(argv[3]) : (int) thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    string allocation = argc == 5 ? argv[4] : "heap";
+    if (allocation == "hugepages") NodeArena::instance().setPolicy(ALLOCATE_HUGE_PAGES);
+    else if (allocation != "heap") {
+        cerr << "unknown allocation: " << allocation << endl;
+        return 1;
+    }
+
+    TRIETree tree;
+    auto buildStart = chrono::steady_clock::now();
+    long loaded = loadDictionary(tree, argv[1]);
+    auto buildEnd = chrono::steady_clock::now();
+    if (loaded < 0) {
+        cerr << "cannot load " << argv[1] << endl;
+        return 1;
+    }
+
+    vector<Query> queries;
+    if (!loadQueries(argv[2], queries)) {
+        cerr << "cannot load " << argv[2] << endl;
+        return 1;
+    }
+
+    vector<vector<uint64_t>> latencies(threads);
+    atomic<long> checksum(0);
+    int counter = openTLBCounter();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    auto replayStart = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            size_t first = queries.size() * t / threads, last = queries.size() * (t + 1) / threads;
+            vector<uint64_t> &mine = latencies[t];
+            mine.reserve(last - first);
+            long sum = 0;
+            for (size_t i = first; i < last; i++) {
+                auto start = chrono::steady_clock::now();
+                sum += run(tree, queries[i]);
+                auto end = chrono::steady_clock::now();
+                mine.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+            }
+            checksum += sum;
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    auto replayEnd = chrono::steady_clock::now();
+    uint64_t tlbMisses = 0;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &tlbMisses, sizeof(tlbMisses)) != sizeof(tlbMisses)) tlbMisses = 0;
+        close(counter);
+    }
+
+    vector<uint64_t> all;
+    for (auto &part : latencies)
+        all.insert(all.end(), part.begin(), part.end());
+    sort(all.begin(), all.end());
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double buildSeconds = chrono::duration<double>(buildEnd - buildStart).count();
+    double replaySeconds = chrono::duration<double>(replayEnd - replayStart).count();
+
+    cout << "keys loaded:    " << loaded << endl;
+    cout << "build time:     " << buildSeconds << " s" << endl;
+    cout << "allocation:     " << allocation << " (" << NodeArena::instance().mappedBytes() / 1048576.0 << " MB in 2 MB regions)" << endl;
+    cout << "peak RSS:       " << usage.ru_maxrss / 1024.0 << " MB" << endl;
+    cout << "queries:        " << all.size() << " on " << threads << " threads" << endl;
+    cout << "throughput:     " << (replaySeconds > 0 ? all.size() / replaySeconds : 0) << " ops/s" << endl;
+    cout << "latency p50:    " << percentile(all, 50) << " us" << endl;
+    cout << "latency p90:    " << percentile(all, 90) << " us" << endl;
+    cout << "latency p99:    " << percentile(all, 99) << " us" << endl;
+    cout << "latency p99.9:  " << percentile(all, 99.9) << " us" << endl;
+    cout << "latency max:    " << (all.empty() ? 0 : all.back() / 1000.0) << " us" << endl;
+    if (counter >= 0)
+        cout << "dTLB misses:    " << tlbMisses << " (" << (all.empty() ? 0 : (double) tlbMisses / all.size()) << " per query)" << endl;
+    else
+        cout << "dTLB misses:    unavailable" << endl;
+    cout << "checksum:       " << checksum << endl;
+    return 0;
+}
@@ -1,395 +1,4 @@
-#include <iostream>
-#include <string>
-#include "vector"
-
-using namespace std;
-struct Node {
-    int value = 0;
-    struct Node *next[256];
-
-};
-
-class TRIETree {
-private:
-    Node *root;
-
-    /**
-     * Służy do zwracania wartości powiązanej z kluczem z drzewa TRIE o korzeniu x
-     *
-     * @param x - węzeł od którego rozpoczynamy wyszukiwanie
-     * @param key - klucz, słowo którego szukamy
-     * @param d - indeks aktualnie przetwarzanej litery w słowie
-     * @return - jeżeli nie znajdujemy wartości zwracamy null, jeśli znajdujemy to zwracamy powiązany z nią węzeł
-     *
-     * jeśli (węzeł nie istnieje) zwracamy null
-       jeśli (aktualnie przetwarzana litera = długość słowa) zwracamy znaleziony węzeł
-       deklaracja kolejnej litery w słowie i przypisanie do niej słowa którego szukamy[indeks aktualnie przetwarzanej litery w słowie]
-       przechodzimy do następnego węzła oraz sprawdzamy następną literę w danym słowie; rekurencyjnie wywołujemy metodę get z nastepującymi argumentami(następny węzeł odpowiadający konkretnej literze)
-       klucz, indeks aktualnie przetwarzanej litery w kluczu +1)
-     *
-     */
-    Node *get(Node *x, string key, int d) {
-        if (x == nullptr) return nullptr;
-        if (d == key.length()) return x;
-        char c = key[d];
-        return get(x->next[c], key, d + 1);
-    }
-
-
-    /**
-     * Służy do wstawiania słowa do drzewa TRIE
-     *
-     * @param x - węzeł od którego rozpoczynamy wstawianie
-     * @param key - klucz, słowo które wstawiamy
-     * @param value - wartość odpowiadająca danemu słowu
-     * @param d - indeks aktualnie przetwarzanej litery w słowie
-     * @return - zwraca przetworzony węzeł
-     *
-     * jeśli węzeł x nie istnieje
-     *  tworzymy go
-       jeśli aktualnie przetwarzana pozycja w słowie jest równa jego ostatniemu znakowi
-        do węzła końcowego przypisujemy wartość odpowiadającą wstawianemu słowu
-        usuwa klucz jeśli wartość przypisana danemu słowu jest równa 0
-        i zwracamy ten wezeł
-
-       deklaracja kolejnej litery w słowie i przypisanie do niej słowa które wstawiamy[indeks aktualnie przetwarzanej litery w słowie]
-       ustawienie następnego poziomu węzła[na kolejną literę w słowie] - rekurencyjnie wywołanie tej samej metody aby w następnym poziomie wstawić daną literę
-       (węzeł[następny poziom],słowo którego szukamy,wartość odpowiadająca danemu słowu, indeks aktualnie przetwarzanej litery w kluczu +1)
-       zwracamy węzeł końcowy
-     */
-    Node *insert(Node *x, string key, int value, int d) {
-        if (x == nullptr) {
-            x = new Node();
-        }
-        if (d == key.size()) {
-            x->value = value;
-            return x;
-        }
-        char c = key[d];
-        x->next[c] = insert(x->next[c], key, value, d + 1);
-        return x;
-    }
-
-    /**
-     * Służy do wyszukiwania najdłuższego przedrostka danego słowa
-     *
-     * @param x - węzeł który aktualnie przetwarzamy
-     * @param query - łańcuch znaków dla którego szukamy najdłuższego przedrostka
-     * @param d - indeks aktualnie przetwarzanej litery w słowie
-     * @param length - ilość już pasujących do słowa liter
-     * @return - zwraca ilość aktualnie pasujących do słowa liter
-     *
-     * jeśli (węzeł który aktualnie przetwarzamy nie istnieje) zwracamy zwraca ilość aktualnie pasujących do słowa liter
-       jeśli (w danym węźle kończy się słowo) ilość aktualnie pasujących do słowa liter = indeks aktualnie przetwarzanej litery w słowie;
-       jeśli (indeks aktualnie przetwarzanej litery w słowie jest rowny długości słowa) zwracamy długość przedrostka jako całe słowo
-       deklaracja kolejnej litery w słowie = słowo którego prefiksu szukamy [indeks aktualnie przetwarzanej litery w słowie]
-       sprawdzamy następny poziom w drzewie dla następnej litery - rekurencyjne wywołujemy te samą metodę z argumentami (węzeł[następny poziom],łańcuch znaków dla którego szukamy najdłuższego przedrostka,
-       indeks aktualnie przetwarzanej litery w słowie,ilość już pasujących do słowa liter)
-     */
-    int longestPrefixOf(Node *x, string query, int d, int length) {
-        if (x == nullptr) return length;
-        if (x->value != 0) length = d;
-        if (d == query.length()) return length;
-        char c = query[d];
-        return longestPrefixOf(x->next[c], query, d + 1, length);
-    }
-
-    /**
-     * Służy do zapisywania kluczy w metodach keys i keysWithPrefix
-     *
-     * @param x - węzeł który aktualnie przetwarzamy
-     * @param key - klucz którego część już dopasowaliśmy
-     * @param queue - służy do przechowywania wszystkich słów
-     *
-     * jeśli węzeł jest pusty
-     *  przerywamy pracę metody
-       jeśli w danym węźle kończy się słowo
-        dodaj słowo do wektora
-       przechodzimy przez cały alfabet w danym węźle
-        i wywołujemy rekurencyjnie metodę collect z argumentami (węzeł odpowiadający danej literze w alfabecie,klucz zwiększony o daną literę w alfabecie,
-        vector)
-        aby znaleźć pozostałe słowa
-     */
-    void collect(Node *x, string key, vector<string> &queue) {
-        if (x == nullptr) {
-            return;
-        }
-        if (x->value != 0) {
-            queue.push_back(key);
-        }
-        for (int c = 0; c < 256; c++) {
-            collect(x->next[c], key + (char) c, queue);
-        }
-    }
-
-    /**
-     * Służy do usuwania kluczy z drzewa TRIE
-     *
-     * @param x - węzeł który aktualnie przetwarzamy
-     * @param key - klucz który zostanie usunięty
-     * @param d - indeks aktualnie przetwarzanej litery w słowie
-     * @return - zwraca przetworzony węzeł
-     *
-     * jeśli (węzeł który aktualnie przetwarzamy jest pusty) zwracamy null;
-        jeśli (indeks aktualnie przetwarzanej litery w słowie jest równy długości słowa) usuń znacznik końca słowa w danym węźle poprzez przypisanie do niego wartośći 0
-        w przeciwnym wypadku
-         deklaracja kolejnej litery w słowie = słowo którego prefiksu szukamy [indeks aktualnie przetwarzanej litery w słowie]
-         rekurencyjne wywołanie metody usuwającej kolejne litery danego słowa klucza z argumentami(węzeł[następny poziom],
-         klucz, indeks aktualnie przetwarzanej litery w słowie + 1)
-
-        jeśli (wartość w aktualnie przetwarzanym węźle nie jest równa 0) zwracamy aktualnie przetwarzany węzeł;
-        przejdź przez cały alfabet w danym węźle
-            jeśli następny znak nie jest nullem
-                zwracamy aktualnie przetwarzany węzeł;
-        zwracamy null;
-     */
-    Node *del(Node *x, string key, int d) {
-        if (x == nullptr) return nullptr;
-        if (d == key.length()) x->value = 0;
-        else {
-            char c = key[d];
-            x->next[c] = del(x->next[c], key, d + 1);
-        }
-        if (x->value != 0) return x;
-        for (int c = 0; c < 256; c++)
-            if (x->next[c] != nullptr)
-                return x;
-        return nullptr;
-    }
-
-
-    /** Służy do zwracania ilości słów w drzewie
-     *
-     * @param x - węzeł od którego rozpoczynamy sprawdzanie
-     * @return - ilość słów w drzewie
-     *
-     * jeśli węzeł od którego rozpoczynamy sprawdzanie nie istnieje zwracamy 0
-        deklaracja licznika i zainicjowanie go wartością 0
-        jeśli wartość w danym węźle nie jest rowna 0 inkrementujemy licznik
-        przechodzimy przez cały alfabet
-            do licznika przypisujemy wartość zwróconą przez rekurencyjne wywołanie tej samej metody z pracującej na następnym poziomie -  size(x->next[i]);
-        zwracamy licznik
-     */
-    int size(Node *x) {
-        if (x == nullptr) return 0;
-
-        int counter = 0;
-        if (x->value != 0) counter++;
-
-        for (char i = 0; i < 127; i++) {
-            counter += size(x->next[i]);
-        }
-        return counter;
-    }
-
-public:
-    /** Służy do zwracania wartości powiązanej z kluczem z drzewa TRIE o korzeniu x
-     *
-     * @param key - słowo którego szukamy
-     * @return zwraca wartość przypisaną danemu słowu w drzewie TRIE, 0 jeśli klucz nie znajduje się w drzewie
-     *
-     * Tworzymy nowy węzeł i przypisujemy do niego wartosć zwróconą przez prywatną metodę get z argumentami(korzeń, słowo którego szukamy,
-     * indeks aktualnie przetwarzanej litery w słowie)
-        jeśli nie znaleziono klucza w drzewie zwróć 0;
-        w przeciwnym wypadku
-        zwracamy wartość odpowiadającą danemu słowu
-     */
-
-    /** Służy do zwrócenia wartości korzneia
-     *
-     * @return korzeń
-     *
-     * zwracamy korzeń
-     */
-    Node* getRoot(){
-        return root;
-    }
-
-    int get(string key) {
-        Node *x = get(root, key, 0);
-        if (x == nullptr) return 0;
-        return x->value;
-    }
-
-    /** Służy do sprawdzenia czy dany klucz znajduje się w drzewie
-     *
-     *
-     * @param key - sprawdzany klucz
-     * @return - wywołanie metody która sprawdza czy klucz znajduje się w drzewie z argumentem (klucz)
-     *
-     * zwracamy wywołanie metody get(klucz) jeśli zwraca ona wartość różną od zera.
-     * O oznacza to że klucz znajduje się w drzewie.
-     */
-    bool contains(string key) {
-        return get(key) != 0;
-    }
-
-    /** Służy do wstawiania słowa do drzewa TRIE
-     *
-     * @param key - słowo które wstawiamy
-     * @param value - indeks przypisany danemu słowu
-     *
-     * przypisujemy do korzenia wynik zwrócony przez prywatną metodę insert z argumentami(korzeń,klucz,wartość,
-     * indeks aktualnie przetwarzanej litery w słowie)
-     *
-     */
-    void insert(string key, int value) {
-        root = insert(root, key, value, 0);
-    }
-
-    /** Służy do wyszukiwania najdłuższego przedrostka danego słowa
-     *
-     * @param query - łańcuch znaków dla którego szukamy najdłuższego przedrostka
-     * @return - najdłuższy pasujący przedrostek odpowiadający danemu słowu
-     *
-     * długość najdłuższego pasującego przedrostku = wynik metody longestPrefixOf z argumentami
-     * (korzeń, łańcuch znaków dla którego szukamy najdłuższego przedrostka, 0, 0);
-        zwracamy najdłuższy prefiks pasujący dla danego słowa
-     */
-    string longestPrefixOf(string query) {
-        int length = longestPrefixOf(root, query, 0, 0);
-        return query.substr(0, length);
-    }
-
-    /** Służy do zwracania wszystkich kluczy dla których prefiksem jest puste słowo
-     *
-     * @return - wszystkie klucze dla których prefiksem jest puste słowo
-     * czyli wszystkie klucze z drzewa
-     *
-     * zwracamy wartość zwróconą przez metodę keysWithPrefix z argumentem(puste słowo);
-     */
-    vector<string> keys() {
-        return keysWithPrefix("");
-    }
-
-    /** Służy do zebrania wszystkich słów pasujących do danego przedrostka w jednym wektorze
-     *
-     * @param prefix - dany przedrostek
-     * @return - zwracamy kolekcję kluczy z danym przedrostkiem
-     *
-     * utworzenie wektora
-        utworzenie nowego węzła i przypisanie do niego wartośći zwracanej przez prywatną metodę get z argumentami(korzeń, przedrostek, 0)
-        zebranie do kolekcji wszystkich słów pasujących do danego przedrostka - wywołanie prywatnej metody collect z argumentami(aktualnie przetwarzany węzeł,przedrostek,wektor)
-        zwracamy wektor słów pasujących do danego przedrostka
-     */
-    vector<string> keysWithPrefix(string prefix) {
-        vector<string> queue;
-        Node *x = get(root, prefix, 0);
-        collect(x, prefix, queue);
-        return queue;
-    }
-
-    /**
-     * Wyszykuje słowa pasujące do danego wzorca, znakiem "." można zastąpić dowolny znak
-     *
-     * @param pat - wzorzec
-     * @return - kolekcja słow pasujących do wzorca
-     *
-     * utworzenie wektora
-       wywołanie metody której zadaniem jest dodanie do kolekcji wszystkich słow pasujących do danego wzorca z argumentami
-       (korzeń, "", prefiks, kolekcja do której zostanie wstawione pasujące słowo)
-       zwracamy wektor pasujących słów
-     */
-    vector<string> keysThatMatch(string pat) {
-        vector<string> q;
-        collect(root, "", pat, q);
-        return q;
-    }
-
-    /**
-     * Służy do zapisywania klucza w metodzie keysThatMatch
-     *
-     * @param x - węzeł który aktualnie przetwarzamy
-     * @param prefix - szukany przedrostek
-     * @param pat - wzorzec
-     * @param q - kolekcja do której zostanie wstawione odpowiednie słowo
-     *
-     * jeśli węzeł który aktualnie przetwarzamy jest pusty przerywamy pracę metody
-        jeśli długość prefiksu jest równa długości wzorca oraz wartość w węźle który aktualnie przetwarzamy nie jest równa 0
-        wstawiany do wektora aktualny prefiks
-        jeśli długość przedrostka jest równa długości wzorca przerywamy pracę metody
-        deklaracja następnej litery w słowie oraz przypisanie do niej następnego znaku wzorca
-        przechodzimy przez cały alfabet w danym węźle
-            jeśli następny znak w danym słowie jest równy "." albo jest równy znakowi na danej pozycji we wzorcu
-                wywołujemy metodę collect z argumentami (węzeł[następny poziom],prefiks + znak na danej pozycji we wzorcu,
-                wzorzec, kolekcja) wstawiającą dany klucz do kolekcji
-     *
-     */
-    void collect(Node *x, string prefix, string pat, vector<string> &q) {
-        if (x == nullptr) return;
-        if (prefix.length() == pat.length() && x->value != 0) q.push_back(prefix);
-        if (prefix.length() == pat.length()) return;
-        char next = pat[prefix.length()];
-        for (int c = 0; c < 256; c++)
-            if (next == '.' || next == c)
-                collect(x->next[c], prefix + (char) c, pat, q);
-    }
-
-    /**
-     * Służy do usuwania danego klucza z drzewa
-     *
-     * @param key - klucz
-     *
-     * przypisanie do korzenia wartości zwróconych przez metodę del z argumentami (korzeń,klucz,0)
-     *
-     */
-    void del(string key) {
-        root = del(root, key, 0);
-    }
-
-    /**
-     * Konstruktor domyślny,
-     *
-     * Utworzenie struktury przechowującej wartość oraz alfabet
-     * Przypisanie do korzenia wartości null
-     *
-     */
-    TRIETree() {
-        Node *node;
-        this->root = nullptr;
-    }
-
-    /**
-     * Służy do zwracania ilości słów w drzewie
-     *
-     * @return zwraca ilość słów w drzewie
-     *
-     * zwracamy wartość zwracaną przez prywatną metodę size z argumentem (korzeń) -  size(root)
-     */
-    int size() {
-        return size(root);
-    }
-
-    /**
-     * Służy do wyświetlenia wszystkich kluczy w drzewie
-     *
-     * @param out - strumień wyjściowy na który zostaną wysłane dane
-     * @param t - obiekt klasy TRIETree, którego klucze mamy za zadanie wyświetlić
-     * @return - strumień wyjściowy
-     *
-     * dla każdego węzła w obiekcie t
-            przekierowujemy na strumień wyjściowy dany klucz
-        zwracamy strumień wyjściowy
-     */
-    friend ostream &operator<<(std::ostream &out, TRIETree &t) {
-        for (auto x : t.keys()) {
-            out << x << endl;
-        }
-        return out;
-    }
-    /**
-     * Służy do sprawdzenia czy drzewo jest puste
-     *
-     * @return - czy drzewo jest puste
-     *
-     * jeśli rozmiar = 0 zwracamy true
-     * w przeciwnym wypadku false
-     */
-    bool isEmpty(){
-        if (size() == 0) return true;
-        return false;
-    }
-};
+#include "TRIETree.h"
 
 int main() {
     TRIETree *a = new TRIETree;
@@ -437,7 +46,7 @@ int main() {
     cout << "a->longestPrefixOf(\"stosowanyy\"):stosowany: " << a->longestPrefixOf("stosowanyy") << endl;
     cout << endl;
 
-    for (int i = 0; i < a->keys().size(); ++i) {
+    for (size_t i = 0; i < a->keys().size(); ++i) {
         cout << a->keys()[i] << endl;
     }
 
@@ -463,6 +72,309 @@ int main() {
     a->del("baner");
 
     cout << *a;
+    cout << endl;
+
+    TRIETree delta;
+    delta.insert("stos", 10);
+    delta.insert("stosik", 7);
+    delta.insert("zupa", 8);
+    a->merge(delta, SUM_VALUES);
+    cout << "a->get(\"stos\"): 13:" << a->get("stos") << endl;
+    cout << "a->get(\"zupa\"): 8:" << a->get("zupa") << endl;
+    cout << "delta.isEmpty(): 1:" << delta.isEmpty() << endl;
+
+    TRIETree removed;
+    removed.insert("zupa", 1);
+    removed.insert("stosik", 1);
+    a->subtract(removed);
+    cout << "a->contains(\"zupa\"): 0:" << a->contains("zupa") << endl;
+
+    TRIETree tenants;
+    tenants.insert("t1/a", 1);
+    tenants.insert("t1/b", 2);
+    tenants.insert("t1/b/c", 3);
+    tenants.insert("t2/a", 4);
+    cout << "tenants.deletePrefix(\"t1/\"): 3:" << tenants.deletePrefix("t1/") << endl;
+    cout << "tenants.deletePrefix(\"t3/\"): 0:" << tenants.deletePrefix("t3/") << endl;
+    cout << tenants << endl;
+
+    cout << "tenants.compact(): 5:" << tenants.compact() << endl;
+    tenants.insert("t2/b", 5);
+    tenants.del("t2/a");
+    cout << "tenants.get(\"t2/b\"): 5:" << tenants.get("t2/b") << endl;
+    cout << "tenants.compact(): 5:" << tenants.compact() << endl;
+    cout << tenants << endl;
+
+    TRIETree compacted;
+    compacted.insert("t2/b", 10);
+    compacted.insert("t4/a", 1);
+    compacted.compact();
+    tenants.merge(compacted, SUM_VALUES);
+    cout << "tenants.get(\"t2/b\"): 15:" << tenants.get("t2/b") << endl;
+    tenants.del("t4/a");
+
+    tenants.enableSuffixIndex();
+    tenants.insert("t3/banan", 6);
+    tenants.insert("t3/ananas", 7);
+    cout << "tenants.keysContaining(\"ana\").size(): 2:" << tenants.keysContaining("ana").size() << endl;
+    tenants.del("t3/banan");
+    for (auto &key : tenants.keysContaining("ana"))
+        cout << key << endl;
+    cout << endl;
+
+    TRIETree words;
+    words.insert("stos", 1);
+    words.insert("stosowany", 2);
+    words.insert("ban", 3);
+    words.insert("banan", 4);
+    istringstream text("bananxstosowanystosow");
+    cout << "words.tokenize(...): 0:5:4 5:1:0 6:9:2 15:4:1 19:2:0:";
+    words.tokenize(text, [](size_t offset, size_t length, int value) {
+        cout << " " << offset << ":" << length << ":" << value;
+    }, EMIT_RUNS, 4);
+    cout << endl << endl;
+
+    cout << "words.forEach(\"\", ...): ban=3 banan=4:";
+    words.forEach("", [](const string &key, int &value) {
+        cout << " " << key << "=" << value;
+        return key != "banan";
+    });
+    cout << endl << endl;
+
+    cout << "words.parallelSize(4): 4:" << words.parallelSize(4) << endl;
+    cout << "words.parallelKeys(4) == words.keys(): 1:" << (words.parallelKeys(4) == words.keys()) << endl;
+    words.parallelExport(cout, "ban", 2);
+    cout << endl;
+
+    cout << "words.countWithPrefix(\"ban\"): 2:" << words.countWithPrefix("ban") << endl;
+    cout << "words.sumWithPrefix(\"stos\"): 3:" << words.sumWithPrefix("stos") << endl;
+    words.del("banan");
+    cout << "words.sumWithPrefix(\"\"): 6:" << words.sumWithPrefix("") << endl;
+    cout << "words.select(1): stos:" << words.select(1) << endl;
+    cout << "words.rank(\"stosik\"): 2:" << words.rank("stosik") << endl;
+    mt19937 generator(2026);
+    cout << "words.contains(words.randomKey(generator)): 1:" << words.contains(words.randomKey(generator)) << endl;
+    cout << "TRIETree().randomKey(generator): :" << TRIETree().randomKey(generator) << endl;
+    cout << "words.addTo(\"stos\", 2): 3:" << words.addTo("stos", 2) << endl;
+    cout << "words.insertIfAbsent(\"stos\", 9): 0:" << words.insertIfAbsent("stos", 9) << endl;
+    cout << "words.compareAndSet(\"stos\", 3, 0): 1:" << words.compareAndSet("stos", 3, 0) << endl;
+    cout << "words.size(): 2:" << words.size() << endl;
+    vector<thread> counters;
+    for (int t = 0; t < 4; t++)
+        counters.emplace_back([&words]() {
+            for (int i = 0; i < 1000; i++) words.concurrentAddTo("licznik", 1);
+        });
+    for (auto &counter : counters) counter.join();
+    cout << "words.get(\"licznik\"): 4000:" << words.get("licznik") << endl;
+    cout << endl;
+
+    words.enableLookupFilter();
+    cout << "words.contains(\"stosowany\"): 1:" << words.contains("stosowany") << endl;
+    for (int i = 0; i < 1000; i++) words.contains("brak" + to_string(i));
+    LookupFilterStats stats = words.lookupFilterStats();
+    cout << "stats.queries: 1001:" << stats.queries << endl;
+    cout << "stats.hitRate > 0.9: 1:" << (stats.hitRate > 0.9) << endl;
+    cout << "stats.falsePositiveRate < 0.1: 1:" << (stats.falsePositiveRate < 0.1) << endl;
+    cout << endl;
+
+    TRIETree cities(FOLD_UTF8);
+    cities.insert("Łódź", 1);
+    cities.insert("KRAKÓW", 2);
+    cities.insert("Kraków Główny", 3);
+    cout << "cities.get(\"ŁÓDŹ\"): 1:" << cities.get("ŁÓDŹ") << endl;
+    cout << "cities.contains(\"kraków\"): 1:" << cities.contains("kraków") << endl;
+    cout << "cities.countWithPrefix(\"KRA\"): 2:" << cities.countWithPrefix("KRA") << endl;
+    cout << "cities.longestPrefixOf(\"ŁÓDŹ KALISKA\"):ŁÓDŹ: " << cities.longestPrefixOf("ŁÓDŹ KALISKA") << endl;
+    for (auto &key : cities.keysWithPrefix("KRAKÓW "))
+        cout << key << endl;
+    cout << endl;
+
+    TRIETree domains;
+    domains.enableReverseIndex();
+    domains.insert("example.com", 1);
+    domains.insert("www.example.com", 2);
+    domains.insert("mail.example.com", 3);
+    domains.insert("example.org", 4);
+    domains.del("mail.example.com");
+    cout << "domains.keysWithSuffix(\".example.com\").size(): 1:" << domains.keysWithSuffix(".example.com").size() << endl;
+    cout << "domains.longestSuffixOf(\"cdn.example.com\"):example.com: " << domains.longestSuffixOf("cdn.example.com") << endl;
+    for (auto &key : domains.keysWithSuffix("example.com"))
+        cout << key << endl;
+    cout << endl;
+
+    NodeArena::instance().setPolicy(ALLOCATE_HUGE_PAGES);
+    TRIETree pages;
+    pages.insert("banan", 1);
+    pages.insert("stos", 3);
+    pages.compact();
+    pages.insert("stosy", 4);
+    cout << "pages.get(\"stosy\"): 4:" << pages.get("stosy") << endl;
+    cout << "pages.getRoot() aligned to cache line: 1:" << ((uintptr_t) pages.getRoot() % NodeArena::CACHE_LINE == 0) << endl;
+    NodeArena::instance().setPolicy(ALLOCATE_HEAP);
+    cout << endl;
+
+    TRIETree kept;
+    kept.insert("stos", 1);
+    kept.insert("stosy", 1);
+    kept.insert("nic", 1);
+    a->intersect(kept);
+    cout << *a << endl;
+    delete a;
+
+    {
+        DurableTRIETree durable("demo", FSYNC_ON_COMMIT, 2);
+        durable.insert("banan", 1);
+        durable.insert("stos", 3);
+        durable.checkpoint();
+        durable.insert("stosy", 4);
+        durable.del("banan");
+    }
+    {
+        DurableTRIETree recovered("demo");
+        cout << "recovered.get(\"banan\"): 0:" << recovered.get("banan") << endl;
+        cout << "recovered.get(\"stos\"): 3:" << recovered.get("stos") << endl;
+        cout << "recovered.get(\"stosy\"): 4:" << recovered.get("stosy") << endl;
+    }
+    remove("demo.wal");
+    remove("demo.snapshot");
+    cout << endl;
+
+    {
+        LSMTRIETree lsm;
+        lsm.insert("banan", 1);
+        lsm.insert("stos", 3);
+        lsm.insert("stosowany", 5);
+        lsm.mergeDelta();
+        lsm.insert("stosy", 4);
+        lsm.del("stosowany");
+        cout << "lsm.get(\"stos\"): 3:" << lsm.get("stos") << endl;
+        cout << "lsm.get(\"stosowany\"): 0:" << lsm.get("stosowany") << endl;
+        cout << "lsm.longestPrefixOf(\"stosowanyy\"):stos: " << lsm.longestPrefixOf("stosowanyy") << endl;
+        lsm.mergeDelta();
+        for (auto &key : lsm.keysWithPrefix("st"))
+            cout << key << endl;
+    }
+    cout << endl;
+
+    {
+        IPv4RoutingTable routes;
+        routes.insert(0x0A000000, 8, 1);
+        routes.insert(0x0A010000, 16, 2);
+        routes.insert(0x0A010180, 25, 3);
+        uint32_t addresses[] = {0x0A020304, 0x0A010203, 0x0A0101F0, 0x0B000001};
+        uint32_t nexthops[4];
+        routes.lookup(addresses, 4, nexthops);
+        cout << "routes.lookup(...): 1 2 3 0:";
+        for (uint32_t nexthop : nexthops) cout << " " << nexthop;
+        cout << endl;
+        routes.del(0x0A010000, 16);
+        cout << "routes.lookup(10.1.2.3): 1:" << routes.lookup(0x0A010203) << endl;
+
+        IPv6RoutingTable routes6;
+        IPv6Address network = {{0x20, 0x01, 0x0d, 0xb8}};
+        IPv6Address host = {{0x20, 0x01, 0x0d, 0xb8, 0x12, 0x34}};
+        routes6.insert(network, 32, 7);
+        routes6.insert(host, 44, 8);
+        cout << "routes6.lookup(2001:db8:1234::): 8:" << routes6.lookup(host) << endl;
+        routes6.del(host, 44);
+        cout << "routes6.lookup(2001:db8:1234::): 7:" << routes6.lookup(host) << endl;
+    }
+    cout << endl;
+
+    {
+        TailTRIETree urls;
+        urls.insert("https://example.com/a/very/long/unique/path", 1);
+        urls.insert("https://example.com/another/long/path", 2);
+        urls.insert("https://example.org/", 3);
+        urls.insert("https://example.com/a", 4);
+        cout << "urls.get(\"https://example.com/another/long/path\"): 2:" << urls.get("https://example.com/another/long/path") << endl;
+        cout << "urls.get(\"https://example.com/an\"): 0:" << urls.get("https://example.com/an") << endl;
+        cout << "urls.longestPrefixOf(\"https://example.com/a/x\"):https://example.com/a: " << urls.longestPrefixOf("https://example.com/a/x") << endl;
+        urls.del("https://example.com/another/long/path");
+        cout << "urls.size(): 3:" << urls.size() << endl;
+        for (auto &key : urls.keysWithPrefix("https://example.com/a/"))
+            cout << key << endl;
+        cout << "urls.memoryUsage() < 60 * sizeof(Node): 1:" << (urls.memoryUsage() < 60 * sizeof(Node)) << endl;
+    }
+    cout << endl;
+
+    {
+        BurstTRIETree bursts;
+        for (int i = 0; i < 1000; i++)
+            bursts.insert("klucz" + to_string(i), i + 1);
+        bursts.insert("klucz", 1001);
+        cout << "bursts.get(\"klucz512\"): 513:" << bursts.get("klucz512") << endl;
+        cout << "bursts.get(\"klucz1000\"): 0:" << bursts.get("klucz1000") << endl;
+        cout << "bursts.longestPrefixOf(\"klucz99x\"):klucz99: " << bursts.longestPrefixOf("klucz99x") << endl;
+        cout << "bursts.keysWithPrefix(\"klucz99\").size(): 11:" << bursts.keysWithPrefix("klucz99").size() << endl;
+        cout << "bursts.keysThatMatch(\"klucz9.\").size(): 10:" << bursts.keysThatMatch("klucz9.").size() << endl;
+        for (int i = 0; i < 1000; i += 2)
+            bursts.del("klucz" + to_string(i));
+        cout << "bursts.size(): 501:" << bursts.size() << endl;
+        cout << "bursts.memoryUsage() < 30 * sizeof(Node): 1:" << (bursts.memoryUsage() < 30 * sizeof(Node)) << endl;
+    }
+    cout << endl;
+
+    {
+        TRIETree forms;
+        const char *stems[] = {"bud", "mal", "stos", "rys", "pis"};
+        const char *endings[] = {"owany", "owana", "owane", "owanie"};
+        int value = 1;
+        for (auto stem : stems)
+            for (auto ending : endings)
+                forms.insert(string(stem) + ending, value++);
+        DAWG dawg(forms);
+        cout << "dawg.size(): 20:" << dawg.size() << endl;
+        cout << "dawg.nodeCount(): 17:" << dawg.nodeCount() << endl;
+        cout << "dawg.get(\"rysowane\"): 15:" << dawg.get("rysowane") << endl;
+        cout << "dawg.get(\"rysowan\"): 0:" << dawg.get("rysowan") << endl;
+        cout << "dawg.longestPrefixOf(\"malowaniem\"):malowanie: " << dawg.longestPrefixOf("malowaniem") << endl;
+        cout << "dawg.keysThatMatch(\"...owana\").size(): 4:" << dawg.keysThatMatch("...owana").size() << endl;
+        for (auto &key : dawg.keysWithPrefix("stosowan"))
+            cout << key << endl;
+
+        FST fst(forms);
+        cout << "fst.get(\"rysowane\"): 15:" << fst.get("rysowane") << endl;
+        cout << "fst.nodeCount() == dawg.nodeCount(): 1:" << (fst.nodeCount() == dawg.nodeCount()) << endl;
+        {
+            ofstream out("demo.fst", ios::binary);
+            fst.save(out);
+        }
+        FST mapped;
+        cout << "mapped.open(\"demo.fst\"): 1:" << mapped.open("demo.fst") << endl;
+        for (auto &entry : mapped.entriesWithPrefix("pisowan"))
+            cout << entry.first << "=" << entry.second << endl;
+        remove("demo.fst");
+    }
+    cout << endl;
+
+    {
+        TRIECache routes(3);
+        routes.insert("/api/", 1);
+        routes.insert("/api/users/", 2);
+        routes.insert("/static/", 3);
+        cout << "routes.longestPrefixOf(\"/api/users/7\"):/api/users/: " << routes.longestPrefixOf("/api/users/7") << endl;
+        cout << "routes.get(\"/api/\"): 1:" << routes.get("/api/") << endl;
+        routes.insert("/admin/", 4);
+        routes.get("/admin/");
+        routes.insert("/login/", 5);
+        cout << "routes.size(): 3:" << routes.size() << endl;
+        cout << "routes.get(\"/api/\"): 0:" << routes.get("/api/") << endl;
+        cout << "routes.get(\"/static/\"): 3:" << routes.get("/static/") << endl;
+        TRIECacheStats stats = routes.statistics();
+        cout << "stats (hits misses evictions): 4 1 2: " << stats.hits << " " << stats.misses << " " << stats.evictions << endl;
+    }
+    cout << endl;
+
+    PersistentTRIETree v1 = PersistentTRIETree().insert("banan", 1).insert("stos", 3);
+    PersistentTRIETree snap = v1.snapshot();
+    PersistentTRIETree v2 = v1.insert("stosy", 4).del("banan");
+
+    cout << "snap.get(\"banan\"): 1:" << snap.get("banan") << endl;
+    cout << "snap.get(\"stosy\"): 0:" << snap.get("stosy") << endl;
+    cout << "v2.get(\"banan\"): 0:" << v2.get("banan") << endl;
+    cout << "v2.get(\"stosy\"): 4:" << v2.get("stosy") << endl;
+    cout << "v2.size(): 2:" << v2.size() << endl;
     return 0;
 }
 
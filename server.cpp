@@ -0,0 +1,241 @@
+#include "Dictionary.h"
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Serwer zapytań do drzewa TRIE przez gniazdo domeny Unix
+ *
+ * Protokół tekstowy, jedno żądanie w wierszu: "GET klucz", "CONTAINS klucz", "LPM zapytanie", "PREFIX przedrostek".
+ * Odpowiedzi: wartość, 1/0, najdłuższy pasujący przedrostek, albo ilość kluczy i kolejne klucze w osobnych wierszach.
+ * Klient może wysłać wiele żądań bez czekania na odpowiedzi (pipelining) - serwer przetwarza wszystkie kompletne
+ * wiersze odczytane z gniazda jedną paczką i odsyła odpowiedzi jednym zapisem, w kolejności żądań.
+ */
+
+static volatile sig_atomic_t running = 1;
+
+/**
+ * Największa długość wiersza żądania; dłuższy wiersz kończy się odpowiedzią "ERR line too long" i zamknięciem połączenia
+ */
+static const size_t MAX_LINE_LENGTH = 1 << 20;
+
+/**
+ * Największy rozmiar niewysłanych odpowiedzi; po jego przekroczeniu połączenie przestaje czytać i obsługiwać żądania
+ * aż klient odbierze odpowiedzi
+ */
+static const size_t MAX_PENDING_OUTPUT = 4 << 20;
+
+/**
+ * Stan połączenia: nieprzetworzone dane wejściowe, niewysłane odpowiedzi oraz znacznik zamykania - po końcu danych
+ * od klienta (lub zbyt długim wierszu) nie czytamy już żądań, a połączenie zamykamy po wysłaniu wszystkich odpowiedzi
+ */
+struct Connection {
+    string in;
+    string out;
+    bool closing = false;
+};
+
+static void stop(int) {
+    running = 0;
+}
+
+/**
+ * Służy do obsłużenia jednego żądania
+ *
+ * @param tree - drzewo
+ * @param line - wiersz żądania, bez znaku nowej linii
+ * @param out - bufor do którego dopisujemy odpowiedź
+ */
+static void handle(TRIETree &tree, const string &line, string &out) {
+    size_t space = line.find(' ');
+    string command = line.substr(0, space);
+    string argument = space == string::npos ? "" : line.substr(space + 1);
+    if (command == "GET") {
+        out += to_string(tree.get(argument));
+        out += '\n';
+    } else if (command == "CONTAINS") {
+        out += tree.contains(argument) ? "1\n" : "0\n";
+    } else if (command == "LPM") {
+        out += tree.longestPrefixOf(argument);
+        out += '\n';
+    } else if (command == "PREFIX") {
+        string keys;
+        int count = 0;
+        tree.forEach(argument, [&](const string &key, int &) {
+            keys += key;
+            keys += '\n';
+            count++;
+            return true;
+        });
+        out += to_string(count);
+        out += '\n';
+        out += keys;
+    } else {
+        out += "ERR unknown command\n";
+    }
+}
+
+/**
+ * Służy do wysłania jak największej części oczekujących odpowiedzi bez blokowania
+ *
+ * @return - false jeśli połączenie zostało zerwane
+ */
+static bool flush(int fd, Connection &connection) {
+    size_t sent = 0;
+    while (sent < connection.out.size()) {
+        ssize_t written = ::send(fd, connection.out.data() + sent, connection.out.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        sent += written;
+    }
+    connection.out.erase(0, sent);
+    return true;
+}
+
+/**
+ * Służy do obsłużenia kompletnych wierszy z bufora wejściowego
+ *
+ * obsługujemy kolejne wiersze dopóki niewysłane odpowiedzi nie przekroczą MAX_PENDING_OUTPUT,
+ *  pozostałe wiersze czekają w buforze aż odpowiedzi zostaną wysłane
+ * jeśli w buforze został tylko niepełny wiersz dłuższy niż MAX_LINE_LENGTH odrzucamy go
+ *  i zamykamy połączenie po wysłaniu odpowiedzi
+ */
+static void process(TRIETree &tree, Connection &connection) {
+    size_t start = 0, end;
+    while (connection.out.size() < MAX_PENDING_OUTPUT && (end = connection.in.find('\n', start)) != string::npos) {
+        handle(tree, connection.in.substr(start, end - start), connection.out);
+        start = end + 1;
+    }
+    connection.in.erase(0, start);
+    if (connection.in.size() > MAX_LINE_LENGTH && connection.in.find('\n') == string::npos) {
+        connection.out += "ERR line too long\n";
+        connection.in.clear();
+        connection.closing = true;
+    }
+}
+
+/**
+ * Służy do odczytania dostępnych danych i obsłużenia kompletnych żądań
+ *
+ * @return - false jeśli wystąpił błąd i połączenie należy zamknąć od razu
+ *
+ * czytamy dopóki niewysłane odpowiedzi nie przekroczą MAX_PENDING_OUTPUT
+ * po każdym odczycie obsługujemy kompletne wiersze
+ * jeśli klient zamknął swoją stronę połączenia zamykamy je po wysłaniu odpowiedzi
+ */
+static bool receive(TRIETree &tree, int fd, Connection &connection) {
+    char buffer[65536];
+    while (!connection.closing && connection.out.size() < MAX_PENDING_OUTPUT) {
+        ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        if (received == 0) {
+            connection.closing = true;
+            break;
+        }
+        connection.in.append(buffer, received);
+        process(tree, connection);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        cerr << "usage: " << argv[0] << " <socket path> <dictionary or snapshot>" << endl;
+        return 1;
+    }
+    string socketPath = argv[1];
+
+    TRIETree tree;
+    long loaded = loadDictionary(tree, argv[2]);
+    if (loaded < 0) {
+        cerr << "cannot load " << argv[2] << endl;
+        return 1;
+    }
+    cerr << "loaded " << loaded << " keys" << endl;
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "socket path too long" << endl;
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ::unlink(socketPath.c_str());
+    if (listener < 0 || ::bind(listener, (sockaddr *) &address, sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+        cerr << "cannot listen on " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    ::epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    signal(SIGPIPE, SIG_IGN);
+
+    unordered_map<int, Connection> connections;
+    epoll_event events[64];
+    while (running) {
+        int ready = ::epoll_wait(epoll, events, 64, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listener) {
+                int client;
+                while ((client = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    event.events = EPOLLIN;
+                    event.data.fd = client;
+                    ::epoll_ctl(epoll, EPOLL_CTL_ADD, client, &event);
+                    connections[client];
+                }
+                continue;
+            }
+
+            Connection &connection = connections[fd];
+            bool open = true;
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !connection.closing)
+                open = receive(tree, fd, connection);
+            if (open && !flush(fd, connection)) open = false;
+            while (open && connection.out.size() < MAX_PENDING_OUTPUT && connection.in.find('\n') != string::npos) {
+                process(tree, connection);
+                if (!flush(fd, connection)) open = false;
+            }
+            if (connection.closing && connection.out.empty()) open = false;
+            if (!open) {
+                ::epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+                ::close(fd);
+                connections.erase(fd);
+                continue;
+            }
+            if (connection.closing || connection.out.size() >= MAX_PENDING_OUTPUT) event.events = EPOLLOUT;
+            else event.events = connection.out.empty() ? EPOLLIN : EPOLLIN | EPOLLOUT;
+            event.data.fd = fd;
+            ::epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event);
+        }
+    }
+
+    for (auto &connection : connections)
+        ::close(connection.first);
+    ::close(epoll);
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    return 0;
+}